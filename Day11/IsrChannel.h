@@ -0,0 +1,109 @@
+#ifndef ISR_CHANNEL_H
+#define ISR_CHANNEL_H
+
+// Deferral channel from an interrupt handler to a task: the handler only posts a small event (what
+// happened, a timestamp, a register value) and returns; the task drains the events in batches and does
+// the real work there. This keeps the interrupt short, unlike doing the work in TIM2_IRQHandler itself
+// (ISR_example.md).
+//
+//     isr::Channel<SampleEvent, 256> channel;      // static storage, no allocation ever
+//     // interrupt handler (or signal handler, or high priority thread on the host)
+//     if (!channel.post(SampleEvent{...})) { ... counted as dropped ... }
+//     // task
+//     channel.drain([](const SampleEvent* events, size_t n) { ... }, 64);
+//
+// One producer and one consumer. post() and drain() are wait-free: a fixed number of steps, no locks, no
+// loops that depend on the other side. They only use lock-free atomics on 32-bit indices, so post() is
+// also safe in a POSIX signal handler that interrupts the task in the middle of drain().
+// When the channel is full, post() drops the new event and counts it; an interrupt cannot wait.
+// Waking the task is not part of the channel: on the device it is xTaskNotifyFromISR after post(), on the
+// host sem_post (which may be called from a signal handler).
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace isr {
+
+struct ChannelStats {
+    uint32_t posted = 0;
+    uint32_t dropped = 0;
+    uint32_t maxDepth = 0;    // most events waiting at once, seen by post()
+    uint32_t drained = 0;
+    uint32_t batches = 0;     // drain() calls that found events
+};
+
+template <typename Event, size_t N>
+class Channel {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<Event>::value, "events are copied with plain stores");
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "post() must not take a lock");
+
+public:
+    static const size_t kCapacity = N;
+
+    // Interrupt side. Returns false (and counts a drop) when the task has N events still to drain.
+    bool post(const Event& e) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        uint32_t depth = t - head.load(std::memory_order_acquire);
+        if (depth == N) {
+            dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        events[t & (N - 1)] = e;
+        tail.store(t + 1, std::memory_order_release);
+        if (depth + 1 > maxDepth.load(std::memory_order_relaxed)) maxDepth.store(depth + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Task side. Hands at most 'maxEvents' waiting events to handler(const Event*, size_t), in order, as one
+    // or two contiguous runs (two when they wrap around the end of the storage), and then frees their slots
+    // in one step. Returns the number of events handled.
+    template <typename Handler>
+    size_t drain(Handler&& handler, size_t maxEvents = N) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        uint32_t available = tail.load(std::memory_order_acquire) - h;
+        size_t n = available < maxEvents ? available : maxEvents;
+        if (n == 0) return 0;
+        size_t index = h & (N - 1);
+        size_t first = n < N - index ? n : N - index;
+        handler(&events[index], first);
+        if (n > first) handler(&events[0], n - first);
+        head.store(h + (uint32_t)n, std::memory_order_release);
+        drainedCount += (uint32_t)n;
+        ++batchCount;
+        return n;
+    }
+
+    size_t pending() const { return tail.load(std::memory_order_acquire) - head.load(std::memory_order_relaxed); }
+
+    // Call from the task side; the producer counters are read with relaxed loads.
+    ChannelStats stats() const {
+        ChannelStats s;
+        s.posted = tail.load(std::memory_order_relaxed);
+        s.dropped = dropped.load(std::memory_order_relaxed);
+        s.maxDepth = maxDepth.load(std::memory_order_relaxed);
+        s.drained = drainedCount;
+        s.batches = batchCount;
+        return s;
+    }
+
+private:
+    std::array<Event, N> events;
+
+    // Written by the interrupt side.
+    alignas(64) std::atomic<uint32_t> tail{0};
+    std::atomic<uint32_t> dropped{0};
+    std::atomic<uint32_t> maxDepth{0};
+
+    // Written by the task side.
+    alignas(64) std::atomic<uint32_t> head{0};
+    uint32_t drainedCount = 0;
+    uint32_t batchCount = 0;
+};
+
+} // namespace isr
+
+#endif // ISR_CHANNEL_H
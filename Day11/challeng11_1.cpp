@@ -0,0 +1,275 @@
+// IsrChannel.h on the host. A timer "interrupt" samples an ADC value 10000 times a second; every sample
+// goes through a 64-tap filter, a threshold check and a formatted log line.
+// Part 1 plays the interrupt with a high priority thread (SCHED_FIFO when allowed) and runs three versions of
+// the handler: the work done inside the handler (as in ISR_example.md), a handler that pushes into a
+// std::deque under a mutex, and a handler that posts a 16-byte event into the channel and wakes the task.
+// It prints how long the handler runs (its share of interrupt latency), how much of that is post() itself
+// (the rest is waking the task), and how long an event waits until the task has handled it.
+// Part 2 posts from a real POSIX signal handler (timer_create with SIGEV_SIGNAL) that interrupts the task
+// thread, also while it is in the middle of drain().
+//     g++ -std=c++17 -O2 -pthread challeng11_1.cpp -o challeng11_1
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cerrno>
+#include <ctime>
+#include <csignal>
+#include <pthread.h>
+#include <semaphore.h>
+#include "IsrChannel.h"
+
+using namespace std;
+
+const int kRateHz = 10000;
+const int kSamples = kRateHz;   // one second per run
+
+struct SampleEvent {   // what the interrupt hands over: 16 bytes
+    uint32_t seq;
+    uint32_t value;
+    uint64_t timestampNs;
+};
+
+uint64_t nowNs() {   // clock_gettime may be called from a signal handler
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+uint32_t readAdc(uint32_t seq) { return 2048 + (uint32_t)(1500 * sin(seq * 0.01)) + seq % 7; }
+
+// The real work for one sample: filter, threshold, log line.
+struct Processing {
+    float taps[64];
+    uint32_t history[64] = {};
+    uint32_t alarms = 0;
+    uint64_t checksum = 0;
+    char line[96];
+
+    Processing() {
+        for (int i = 0; i < 64; ++i) taps[i] = 1.0f / 64;
+    }
+
+    void handle(const SampleEvent& e) {
+        history[e.seq % 64] = e.value;
+        float filtered = 0;
+        for (int i = 0; i < 64; ++i) filtered += taps[i] * history[(e.seq - i) % 64];
+        bool alarm = filtered > 3400;
+        alarms += alarm;
+        int n = snprintf(line, sizeof line, "t=%llu seq=%u raw=%u filtered=%.1f%s",
+                         (unsigned long long)e.timestampNs, e.seq, e.value, filtered, alarm ? " ALARM" : "");
+        checksum = checksum * 31 + n + e.seq;
+    }
+};
+
+struct Percentiles {
+    double median, p99, max;
+};
+
+Percentiles percentiles(vector<uint32_t> ns) {
+    sort(ns.begin(), ns.end());
+    return {ns[ns.size() / 2] / 1000.0, ns[ns.size() * 99 / 100] / 1000.0, ns.back() / 1000.0};
+}
+
+void print(const char* name, const Percentiles& p) {
+    cout << "  " << name << setprecision(2) << p.median << " / " << p.p99 << " / " << p.max << " us" << endl;
+}
+
+bool makeRealTime(pthread_t t, int priority) {
+    sched_param sp;
+    sp.sched_priority = priority;
+    return pthread_setschedparam(t, SCHED_FIFO, &sp) == 0;
+}
+
+// ---- Part 1: the interrupt as a high priority thread ----
+
+// Calls handler(seq) at kRateHz and returns how long each call took, in ns.
+template <typename Handler>
+vector<uint32_t> runInterrupt(Handler handler, bool& realTime) {
+    vector<uint32_t> durations(kSamples);
+    thread irq([&] {
+        realTime = makeRealTime(pthread_self(), 80);
+        timespec next;
+        clock_gettime(CLOCK_MONOTONIC, &next);
+        for (int seq = 0; seq < kSamples; ++seq) {
+            next.tv_nsec += 1000000000 / kRateHz;
+            if (next.tv_nsec >= 1000000000) {
+                next.tv_nsec -= 1000000000;
+                ++next.tv_sec;
+            }
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+            uint64_t t0 = nowNs();
+            handler((uint32_t)seq, t0);
+            durations[seq] = (uint32_t)(nowNs() - t0);
+        }
+    });
+    irq.join();
+    return durations;
+}
+
+// ---- Part 2: the interrupt as a signal handler ----
+
+isr::Channel<SampleEvent, 256> signalChannel;
+sem_t signalWake;
+uint32_t signalPostNs[kSamples];
+volatile sig_atomic_t signalSeq = 0;
+
+void onTimerSignal(int) {
+    int saved = errno;
+    uint32_t seq = (uint32_t)signalSeq;
+    if (seq < (uint32_t)kSamples) {
+        uint64_t t0 = nowNs();
+        signalChannel.post(SampleEvent{seq, readAdc(seq), t0});
+        signalPostNs[seq] = (uint32_t)(nowNs() - t0);
+        sem_post(&signalWake);
+        signalSeq = seq + 1;
+    }
+    errno = saved;
+}
+
+int main() {
+    bool realTime = false;
+    cout << fixed << "Timer interrupt at " << kRateHz << " Hz for 1 s, handler time median / p99 / max:" << endl;
+
+    // Work inside the handler.
+    Processing inIrq;
+    Percentiles workInIrq = percentiles(runInterrupt([&](uint32_t seq, uint64_t t) {
+        inIrq.handle(SampleEvent{seq, readAdc(seq), t});
+    }, realTime));
+
+    // Handler pushes into a mutex-protected queue; the task swaps it out and processes.
+    Processing viaQueue;
+    mutex mtx;
+    deque<SampleEvent> queue;
+    atomic<bool> running{true};
+    thread queueTask([&] {
+        deque<SampleEvent> batch;
+        while (true) {
+            {
+                lock_guard<mutex> lock(mtx);
+                if (queue.empty() && !running.load(memory_order_acquire)) break;
+                batch.swap(queue);
+            }
+            for (const SampleEvent& e : batch) viaQueue.handle(e);
+            batch.clear();
+            this_thread::sleep_for(chrono::microseconds(500));
+        }
+    });
+    Percentiles mutexQueue = percentiles(runInterrupt([&](uint32_t seq, uint64_t t) {
+        lock_guard<mutex> lock(mtx);
+        queue.push_back(SampleEvent{seq, readAdc(seq), t});
+    }, realTime));
+    running.store(false, memory_order_release);
+    queueTask.join();
+
+    // Handler posts into the channel and wakes the task.
+    static isr::Channel<SampleEvent, 256> channel;
+    Processing viaChannel;
+    sem_t wake;
+    sem_init(&wake, 0, 0);
+    vector<uint32_t> waited;   // from the interrupt to the end of the task's processing
+    waited.reserve(kSamples);
+    running.store(true);
+    thread channelTask([&] {
+        while (running.load(memory_order_acquire) || channel.pending()) {
+            sem_wait(&wake);
+            channel.drain([&](const SampleEvent* e, size_t n) {
+                for (size_t i = 0; i < n; ++i) viaChannel.handle(e[i]);
+                uint64_t done = nowNs();
+                for (size_t i = 0; i < n; ++i) waited.push_back((uint32_t)(done - e[i].timestampNs));
+            }, 64);
+        }
+    });
+    vector<uint32_t> postOnly(kSamples);
+    Percentiles posted = percentiles(runInterrupt([&](uint32_t seq, uint64_t t) {
+        channel.post(SampleEvent{seq, readAdc(seq), t});
+        postOnly[seq] = (uint32_t)(nowNs() - t);
+        sem_post(&wake);
+    }, realTime));
+    running.store(false, memory_order_release);
+    sem_post(&wake);
+    channelTask.join();
+
+    print("work in the handler:      ", workInIrq);
+    print("mutex + std::deque push:  ", mutexQueue);
+    print("channel post + wake:      ", posted);
+    print("  of which post():        ", percentiles(postOnly));
+    isr::ChannelStats cs = channel.stats();
+    Percentiles late = percentiles(waited);
+    cout << "  channel: " << cs.posted << " events, " << cs.dropped << " dropped, " << setprecision(1)
+         << (double)cs.drained / cs.batches << " per batch, at most " << cs.maxDepth << " waiting; interrupt to processed "
+         << setprecision(0) << late.median << " / " << late.p99 << " / " << late.max << " us" << endl;
+    bool sameWork = inIrq.checksum == viaQueue.checksum && inIrq.checksum == viaChannel.checksum &&
+                    inIrq.alarms == viaChannel.alarms;
+    cout << "  " << (realTime ? "SCHED_FIFO interrupt thread" : "normal priority interrupt thread (SCHED_FIFO not allowed)")
+         << ", all three did " << (sameWork ? "the same work" : "DIFFERENT work") << endl;
+
+    // ---- Part 2: signal handler ----
+    sem_init(&signalWake, 0, 0);
+    struct sigaction sa = {};
+    sa.sa_handler = onTimerSignal;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGRTMIN, &sa, nullptr);
+    sigevent sev = {};
+    sev.sigev_notify = SIGEV_SIGNAL;
+    sev.sigev_signo = SIGRTMIN;
+    timer_t timer;
+    timer_create(CLOCK_MONOTONIC, &sev, &timer);
+    itimerspec period = {};
+    period.it_interval.tv_nsec = period.it_value.tv_nsec = 1000000000 / kRateHz;
+    timer_settime(timer, 0, &period, nullptr);
+
+    Processing viaSignal;
+    uint32_t expected = 0;
+    bool inOrder = true;
+    auto start = nowNs();
+    while (nowNs() - start < 3000000000ull) {   // the signal handler stops posting after kSamples events
+        if (sem_wait(&signalWake) != 0) continue;   // EINTR
+        signalChannel.drain([&](const SampleEvent* e, size_t n) {
+            for (size_t i = 0; i < n; ++i) {
+                inOrder = inOrder && e[i].seq == expected++;
+                viaSignal.handle(e[i]);
+            }
+        }, 64);
+        if (signalSeq >= kSamples && signalChannel.pending() == 0) break;
+    }
+    timer_delete(timer);
+    signal(SIGRTMIN, SIG_IGN);
+
+    isr::ChannelStats ss = signalChannel.stats();
+    vector<uint32_t> postNs(signalPostNs, signalPostNs + min<uint32_t>(signalSeq, kSamples));
+    Percentiles sp = percentiles(postNs);
+    cout << "Signal handler at " << kRateHz << " Hz: " << ss.posted << " events, " << ss.dropped << " dropped, "
+         << setprecision(1) << (double)ss.drained / max<uint32_t>(ss.batches, 1) << " per batch, "
+         << (inOrder ? "all in order" : "OUT OF ORDER") << endl;
+    print("post() in the handler, median / p99 / max: ", sp);
+
+    return sameWork && inOrder && ss.drained == ss.posted ? 0 : 1;
+}
+
+
+/*Why the handler only posts an event:
+
+1. Everything an interrupt handler does delays every interrupt of the same or lower priority, and the
+   task that was interrupted. Filtering and formatting in the handler cost microseconds; copying 16 bytes
+   and moving an index costs tens of nanoseconds (the measured 0.1 us includes reading the clock).
+   On the host, waking the task (sem_post, a system call) is most of the handler time; on the device
+   xTaskNotifyFromISR is a few dozen instructions.
+2. A mutex in an interrupt is not allowed on the device (the task holding it cannot run until the handler
+   returns) and on the host it makes the handler wait whenever the task holds the lock; std::deque also
+   allocates from time to time. Both show up as the long tail of the handler time.
+3. The channel is wait-free: post() never waits for the task and never loops, so its worst case is a few
+   stores. Each side writes only its own index, so no lock and no read-modify-write are needed.
+4. The task drains everything that is waiting in one call, so a burst of interrupts costs one wake-up, and
+   the events arrive as contiguous arrays.
+5. If the task falls behind by more than the channel holds, events are dropped and counted instead of
+   blocking the interrupt. The capacity is chosen for the longest time the task may not run.
+*/
@@ -0,0 +1,313 @@
+#ifndef UART_DMA_RX_H
+#define UART_DMA_RX_H
+
+// UART receive path built the way HAL_UARTEx_ReceiveToIdle_DMA works on an STM32: the DMA writes every byte
+// into a circular buffer on its own, and the CPU is only interrupted on events (line idle, half / full
+// buffer), not per byte. Frames are handed to the task as spans into the buffer, without copying.
+//
+//     uart::DmaRx rx(4096, uart::Framing::IdleLine);
+//     // "hardware" side, one thread: the DMA controller and the USART interrupt
+//     rx.dmaWrite(bytes, n);          // DMA stores received bytes; raises half / full transfer events
+//     rx.idleLine();                  // USART IDLE interrupt: the line was quiet for one character
+//     // task side, one thread
+//     uart::Frame f;
+//     while (rx.next(f, std::chrono::milliseconds(100))) {
+//         ... f.part[0] / f.length[0] and, if the frame wraps around the end, f.part[1] / f.length[1] ...
+//         rx.release(f);              // the DMA may now reuse these bytes
+//     }
+//
+// Framing:
+//   IdleLine:  a frame ends when the line goes idle (Modbus RTU, most binary protocols). The interrupt only
+//              records the DMA position in a small lock-free queue.
+//   Delimiter: a frame ends after the delimiter byte (text protocols, NMEA, AT commands). The task searches
+//              the new bytes with memchr; idle, half and full transfer events only wake it up. When the
+//              whole buffer holds no delimiter (a line longer than the buffer, a binary burst, noise), it is
+//              handed out as one damaged frame so the buffer can be released; the search resumes after it.
+//
+// Overrun: the task has not released enough of the buffer and new bytes have no room. A real DMA in circular
+// mode overwrites the oldest bytes; the simulated one drops the new bytes instead (so the host never reads
+// bytes while they are being written), counts them, and remembers where in the stream they were lost.
+// The frame around that position (both frames, when it is exactly between two) comes out with 'damaged' set, so the task knows not to trust it.
+//
+// Positions are byte counts since the start of the stream (64 bit, they do not wrap); the buffer index is
+// position % capacity. Waking the task uses a mutex and a condition variable on the host; on the device this
+// is a task notification from the interrupt (xTaskNotifyFromISR).
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace uart {
+
+enum class Framing { IdleLine, Delimiter };
+
+struct Frame {
+    const uint8_t* part[2] = {nullptr, nullptr};   // the second part is used when the frame wraps around
+    size_t length[2] = {0, 0};
+    uint64_t begin = 0, end = 0;                    // stream positions [begin, end)
+    bool damaged = false;                           // bytes inside this frame were lost to an overrun
+
+    size_t size() const { return length[0] + length[1]; }
+    uint8_t operator[](size_t i) const { return i < length[0] ? part[0][i] : part[1][i - length[0]]; }
+
+    // For code that needs the frame in one piece (a parser that wants contiguous bytes).
+    size_t copyTo(uint8_t* out, size_t capacity) const {
+        size_t a = std::min(length[0], capacity), b = std::min(length[1], capacity - a);
+        std::memcpy(out, part[0], a);
+        if (b) std::memcpy(out + a, part[1], b);
+        return a + b;
+    }
+};
+
+struct RxStats {
+    uint64_t bytes = 0;           // stored by the DMA
+    uint64_t frames = 0;          // handed to the task
+    uint64_t overrunBytes = 0;    // lost because the buffer was full
+    uint64_t damagedFrames = 0;
+    uint64_t lostIdleEvents = 0;  // IdleLine: boundaries that did not fit the queue (their frames are merged)
+    uint64_t oversizedFrames = 0; // Delimiter: full buffers handed out without a delimiter (also damaged)
+    uint64_t interrupts = 0;      // idle + half transfer + transfer complete events
+    uint64_t maxFill = 0;         // high-water mark of unreleased bytes
+};
+
+class DmaRx {
+public:
+    DmaRx(size_t capacity, Framing framing, uint8_t delimiter = '\n')
+        : buffer(capacity), framing(framing), delimiter(delimiter) {}
+
+    DmaRx(const DmaRx&) = delete;
+    DmaRx& operator=(const DmaRx&) = delete;
+
+    // ---- hardware side (DMA and USART interrupt): one thread ----
+
+    // Stores received bytes like the DMA does; returns how many fit. Crossing the middle or the end of the
+    // buffer raises the half / full transfer interrupt.
+    size_t dmaWrite(const uint8_t* bytes, size_t n) {
+        uint64_t pos = dmaPos.load(std::memory_order_relaxed);
+        uint64_t used = pos - readPos.load(std::memory_order_acquire);
+        size_t room = buffer.size() - (size_t)used;
+        size_t stored = std::min(n, room);
+        if (stored < n) {
+            overrunBytes.fetch_add(n - stored, std::memory_order_relaxed);
+            markDamaged(pos + stored);
+        }
+        for (size_t done = 0; done < stored;) {
+            size_t index = (size_t)((pos + done) % buffer.size());
+            size_t chunk = std::min(stored - done, buffer.size() - index);
+            std::memcpy(&buffer[index], bytes + done, chunk);
+            done += chunk;
+        }
+        uint64_t newPos = pos + stored;
+        dmaPos.store(newPos, std::memory_order_release);
+        if (used + stored > maxFill.load(std::memory_order_relaxed)) maxFill.store(used + stored, std::memory_order_relaxed);
+
+        size_t half = buffer.size() / 2;
+        uint64_t halves = newPos / half - pos / half;   // half / full transfer events crossed by this write
+        if (halves) {
+            interrupts.fetch_add(halves, std::memory_order_relaxed);
+            if (framing == Framing::Delimiter) wake();
+        }
+        return stored;
+    }
+
+    // USART IDLE interrupt: the line has been quiet for one character time.
+    void idleLine() {
+        interrupts.fetch_add(1, std::memory_order_relaxed);
+        uint64_t pos = dmaPos.load(std::memory_order_relaxed);
+        if (framing == Framing::IdleLine) {
+            if (pos == lastBoundary) return;   // idle again without new bytes
+            lastBoundary = pos;
+            if (!boundaries.push(pos)) {
+                // The task is more than a queue behind: this frame and the next one come out as one, damaged.
+                lostIdleEvents.fetch_add(1, std::memory_order_relaxed);
+                markDamaged(pos);
+            }
+        }
+        wake();
+    }
+
+    // No more bytes will come: next() returns false once everything received has been handed out, including
+    // the bytes after the last idle event or delimiter (as one last frame).
+    void close() {
+        closed.store(true, std::memory_order_release);
+        wake();
+    }
+
+    // ---- task side: one thread ----
+
+    // Waits up to 'timeout' for the next frame. Frames must be released in the order they were returned.
+    template <typename Rep, typename Period>
+    bool next(Frame& f, std::chrono::duration<Rep, Period> timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (true) {
+            uint64_t seen = wakeups.load(std::memory_order_acquire);
+            if (tryNext(f)) return true;
+            if (closed.load(std::memory_order_acquire)) return tryNext(f);
+            std::unique_lock<std::mutex> lock(mtx);
+            if (!cv.wait_until(lock, deadline, [&] { return wakeups.load(std::memory_order_acquire) != seen; })) {
+                return false;
+            }
+        }
+    }
+
+    // Returns a frame's bytes to the DMA.
+    void release(const Frame& f) { readPos.store(f.end, std::memory_order_release); }
+
+    RxStats stats() const {
+        RxStats s;
+        s.bytes = dmaPos.load(std::memory_order_acquire);
+        s.frames = frameCount;
+        s.overrunBytes = overrunBytes.load(std::memory_order_relaxed);
+        s.damagedFrames = damagedCount;
+        s.lostIdleEvents = lostIdleEvents.load(std::memory_order_relaxed);
+        s.oversizedFrames = oversizedCount;
+        s.interrupts = interrupts.load(std::memory_order_relaxed);
+        s.maxFill = maxFill.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    size_t capacity() const { return buffer.size(); }
+
+private:
+    // Single-producer / single-consumer queue of stream positions, fixed size, usable from an interrupt.
+    class PositionQueue {
+    public:
+        static const size_t kSize = 256;
+
+        bool push(uint64_t v) {
+            size_t t = tail.load(std::memory_order_relaxed);
+            if (t - head.load(std::memory_order_acquire) == kSize) return false;
+            items[t % kSize] = v;
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+        bool front(uint64_t& v) const {
+            size_t h = head.load(std::memory_order_relaxed);
+            if (h == tail.load(std::memory_order_acquire)) return false;
+            v = items[h % kSize];
+            return true;
+        }
+        void pop() { head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    private:
+        uint64_t items[kSize];
+        std::atomic<size_t> head{0}, tail{0};
+    };
+
+    bool tryNext(Frame& f) {
+        uint64_t end;
+        bool found = framing == Framing::IdleLine ? boundaries.front(end) : findDelimiter(end);
+        if (found && framing == Framing::IdleLine) boundaries.pop();
+        bool oversized = false;
+        if (!found && framing == Framing::Delimiter && dmaPos.load(std::memory_order_acquire) - cursor >= buffer.size()) {
+            // No delimiter in the whole buffer: waiting for one would never free any room.
+            end = cursor + buffer.size();
+            found = oversized = true;
+        }
+        if (!found) {
+            if (!closed.load(std::memory_order_acquire)) return false;
+            end = dmaPos.load(std::memory_order_acquire);   // whatever is left after the last boundary
+            if (end == cursor) return false;
+        }
+        makeFrame(f, cursor, end);
+        if (oversized) {
+            f.damaged = true;
+            ++oversizedCount;
+        }
+        cursor = end;
+        ++frameCount;
+        if (f.damaged) ++damagedCount;
+        return true;
+    }
+
+    // Searches the bytes that arrived since the last search; 'end' is the position after the delimiter.
+    bool findDelimiter(uint64_t& end) {
+        uint64_t limit = dmaPos.load(std::memory_order_acquire);
+        while (scanned < limit) {
+            size_t index = (size_t)(scanned % buffer.size());
+            size_t chunk = (size_t)std::min<uint64_t>(limit - scanned, buffer.size() - index);
+            const void* hit = std::memchr(&buffer[index], delimiter, chunk);
+            if (hit) {
+                scanned += (const uint8_t*)hit - &buffer[index] + 1;
+                end = scanned;
+                return true;
+            }
+            scanned += chunk;
+        }
+        return false;
+    }
+
+    void makeFrame(Frame& f, uint64_t begin, uint64_t end) {
+        f.begin = begin;
+        f.end = end;
+        size_t index = (size_t)(begin % buffer.size());
+        size_t n = (size_t)(end - begin);
+        f.part[0] = &buffer[index];
+        f.length[0] = std::min(n, buffer.size() - index);
+        f.part[1] = &buffer[0];
+        f.length[1] = n - f.length[0];
+
+        // Lost bytes at stream position p belong to the frame with begin <= p <= end. When p is exactly the
+        // end of a frame, the bytes may have been the tail of this frame or the head of the next one: both
+        // are flagged, so the entry stays for the next frame.
+        // Positions that did not fit the queue: every frame up to the last of them is flagged.
+        f.damaged = begin < unqueuedDropEnd.load(std::memory_order_acquire);
+        uint64_t p;
+        while (drops.front(p) && p <= end) {
+            if (p >= begin) f.damaged = true;
+            if (p == end) break;
+            drops.pop();
+        }
+    }
+
+    // Hardware side: the frame around stream position p lost bytes (or an idle event).
+    void markDamaged(uint64_t p) {
+        if (p == lastDrop) return;   // one entry per gap in the stream
+        lastDrop = p;
+        if (!drops.push(p)) unqueuedDropEnd.store(p + 1, std::memory_order_release);
+    }
+
+    void wake() {
+        wakeups.fetch_add(1, std::memory_order_release);
+        std::lock_guard<std::mutex> lock(mtx);
+        cv.notify_one();
+    }
+
+    std::vector<uint8_t> buffer;
+    const Framing framing;
+    const uint8_t delimiter;
+
+    // Written by the hardware side.
+    alignas(64) std::atomic<uint64_t> dmaPos{0};
+    std::atomic<uint64_t> overrunBytes{0};
+    std::atomic<uint64_t> interrupts{0};
+    std::atomic<uint64_t> maxFill{0};
+    std::atomic<uint64_t> lostIdleEvents{0};
+    std::atomic<uint64_t> unqueuedDropEnd{0};   // 1 + the last damaged position that did not fit 'drops'
+    uint64_t lastBoundary = 0;
+    uint64_t lastDrop = UINT64_MAX;
+    PositionQueue boundaries;
+    PositionQueue drops;
+
+    // Written by the task side.
+    alignas(64) std::atomic<uint64_t> readPos{0};
+    uint64_t cursor = 0;     // end of the last frame handed out
+    uint64_t scanned = 0;    // Delimiter: bytes already searched
+    uint64_t frameCount = 0;
+    uint64_t damagedCount = 0;
+    uint64_t oversizedCount = 0;
+
+    std::atomic<bool> closed{false};
+    std::atomic<uint64_t> wakeups{0};
+    std::mutex mtx;
+    std::condition_variable cv;
+};
+
+} // namespace uart
+
+#endif // UART_DMA_RX_H
@@ -0,0 +1,269 @@
+// UartDmaRx.h with a simulated line. A "line" thread plays the UART and the DMA: it delivers bytes at the
+// baud rate into the circular buffer and raises the IDLE interrupt after every packet, as the USART does
+// when the line stays quiet for one character. The task thread takes frames as spans and checks them.
+// Part 1 measures the receive cost per byte on a recorded stream: one interrupt callback per byte that
+// copies into a frame buffer and then into a queue (HAL_UART_Receive_IT style, as in Uart.md), against
+// DMA chunks, one idle event per packet and zero-copy frames.
+// Part 2 runs in real time at 3 Mbaud: binary packets with idle-line framing, then back-to-back text lines
+// with delimiter framing, then binary packets with a small buffer and a task that stalls, to show overruns
+// being counted and the damaged frames flagged. Last, a line longer than a 16-byte buffer with delimiter
+// framing, which must come out as a damaged frame so the receiver can resync at the next delimiter.
+//     g++ -std=c++17 -O2 -pthread challeng12_1.cpp -o challeng12_1
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <deque>
+#include <string>
+#include <random>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <chrono>
+#include "UartDmaRx.h"
+
+using namespace std;
+
+const double kBaud = 3e6;
+const double kBytesPerSecond = kBaud / 10;   // start, 8 data, stop
+
+double seconds(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Binary packet: sequence (2 bytes), payload length, payload, sum of all previous bytes.
+vector<uint8_t> makePacket(uint16_t seq, mt19937& rng) {
+    vector<uint8_t> p = {(uint8_t)seq, (uint8_t)(seq >> 8), 0};
+    size_t n = 8 + rng() % 200;
+    p[2] = (uint8_t)n;
+    for (size_t i = 0; i < n; ++i) p.push_back((uint8_t)rng());
+    uint8_t sum = 0;
+    for (uint8_t b : p) sum += b;
+    p.push_back(sum);
+    return p;
+}
+
+template <typename Bytes>
+bool packetValid(const Bytes& f, size_t n) {
+    if (n < 4 || f[2] + 4u != n) return false;
+    uint8_t sum = 0;
+    for (size_t i = 0; i + 1 < n; ++i) sum += f[i];
+    return sum == f[n - 1];
+}
+
+// NMEA-like text line: "$GPxxx,<seq>,<fields>*hh\r\n" with the XOR checksum of the text between '$' and '*'.
+string makeLine(uint32_t seq, mt19937& rng) {
+    string body = "GPGGA," + to_string(seq);
+    for (int i = 0, n = 4 + rng() % 10; i < n; ++i) body += "," + to_string(rng() % 100000);
+    uint8_t x = 0;
+    for (char c : body) x ^= (uint8_t)c;
+    char hex[4];
+    snprintf(hex, sizeof hex, "%02X", x);
+    return "$" + body + "*" + hex + "\r\n";
+}
+
+bool lineValid(const uart::Frame& f) {
+    size_t n = f.size();
+    if (n < 6 || f[0] != '$' || f[n - 5] != '*') return false;
+    uint8_t x = 0;
+    for (size_t i = 1; i < n - 5; ++i) x ^= f[i];
+    auto hex = [](uint8_t c) { return c <= '9' ? c - '0' : c - 'A' + 10; };
+    return ((hex(f[n - 4]) << 4) | hex(f[n - 3])) == x;
+}
+
+// ---- Part 1: the per-byte interrupt path ----
+
+struct PerByteRx {   // HAL_UART_Receive_IT(&huart, &byte, 1) and a callback that re-arms it for every byte
+    vector<uint8_t> frame;
+    deque<vector<uint8_t>> queue;   // frames for the task, copied
+    mutex mtx;
+
+    void rxCpltCallback(uint8_t byte) { frame.push_back(byte); }
+    void idle() {
+        lock_guard<mutex> lock(mtx);
+        queue.push_back(frame);
+        frame.clear();
+    }
+    bool take(vector<uint8_t>& out) {
+        lock_guard<mutex> lock(mtx);
+        if (queue.empty()) return false;
+        out = std::move(queue.front());
+        queue.pop_front();
+        return true;
+    }
+};
+
+// ---- Part 2: the line ----
+
+// Plays 'packets' at the baud rate for 'duration' seconds: bytes go to the DMA in the slices they would
+// have arrived in, an idle interrupt follows each packet when 'idleGaps' is set.
+void runLine(uart::DmaRx& rx, const vector<vector<uint8_t>>& packets, double duration, bool idleGaps) {
+    auto start = chrono::steady_clock::now();
+    double lineTime = 0;   // seconds of line time used so far
+    for (size_t i = 0; lineTime < duration; i = (i + 1) % packets.size()) {
+        const vector<uint8_t>& p = packets[i];
+        size_t sent = 0;
+        while (sent < p.size()) {
+            size_t due = (size_t)((seconds(start) - lineTime) * kBytesPerSecond) + 1;
+            size_t n = min(due, p.size() - sent);
+            rx.dmaWrite(&p[sent], n);
+            sent += n;
+            lineTime += n / kBytesPerSecond;
+            if (sent < p.size()) this_thread::sleep_for(chrono::microseconds(50));
+        }
+        if (idleGaps) {
+            lineTime += 2 / kBytesPerSecond;   // two characters of silence
+            this_thread::sleep_until(start + chrono::duration_cast<chrono::steady_clock::duration>(
+                                                 chrono::duration<double>(lineTime)));
+            rx.idleLine();
+        }
+    }
+    rx.close();
+}
+
+struct RunResult {
+    uint64_t valid = 0, invalid = 0, damagedButValid = 0;
+    uart::RxStats stats;
+};
+
+RunResult runRealTime(size_t capacity, uart::Framing framing, const vector<vector<uint8_t>>& packets, int stallEvery) {
+    uart::DmaRx rx(capacity, framing);
+    RunResult r;
+    thread task([&] {
+        uart::Frame f;
+        uint64_t count = 0;
+        while (rx.next(f, chrono::milliseconds(500))) {
+            bool ok = framing == uart::Framing::Delimiter ? lineValid(f) : packetValid(f, f.size());
+            if (f.damaged) r.damagedButValid += ok;
+            else if (ok) ++r.valid;
+            else ++r.invalid;
+            rx.release(f);
+            if (stallEvery && ++count % stallEvery == 0) this_thread::sleep_for(chrono::milliseconds(20));
+        }
+    });
+    runLine(rx, packets, 1.0, framing == uart::Framing::IdleLine);
+    task.join();
+    r.stats = rx.stats();
+    return r;
+}
+
+// 20 bytes without a delimiter into a 16-byte buffer, then "ok\n" (lost, the buffer is full), then "ok\n" twice more.
+// Returns true when the receiver hands out the full buffer as a damaged frame and delivers a clean "ok\n" after it.
+bool longLineRecovers() {
+    uart::DmaRx rx(16, uart::Framing::Delimiter);
+    const string noise(20, 'x'), line = "ok\n";
+    rx.dmaWrite((const uint8_t*)noise.data(), noise.size());
+    rx.dmaWrite((const uint8_t*)line.data(), line.size());
+    vector<uart::Frame> frames;
+    uart::Frame f;
+    for (int i = 0; i < 3; ++i) {
+        if (i) rx.dmaWrite((const uint8_t*)line.data(), line.size());
+        while (rx.next(f, chrono::milliseconds(0))) {
+            frames.push_back(f);
+            rx.release(f);
+        }
+    }
+    uart::RxStats s = rx.stats();
+    cout << "  delimiter framing, 20-byte line in a 16-byte buffer: " << s.frames << " frames (" << s.oversizedFrames
+         << " without delimiter, " << s.damagedFrames << " damaged), " << s.overrunBytes << " bytes lost to overrun" << endl;
+    if (frames.size() < 2 || frames[0].size() != 16 || !frames[0].damaged) return false;
+    const uart::Frame& last = frames.back();
+    return !last.damaged && last.size() == 3 && last[0] == 'o' && last[1] == 'k' && last[2] == '\n';
+}
+
+void report(const char* name, size_t capacity, const RunResult& r) {
+    const uart::RxStats& s = r.stats;
+    cout << "  " << name << ", " << capacity << "-byte buffer: " << s.bytes << " bytes, " << s.frames << " frames, "
+         << s.interrupts << " interrupts (" << setprecision(0) << (double)s.bytes / max<uint64_t>(s.interrupts, 1)
+         << " bytes each), max fill " << s.maxFill << endl;
+    cout << "    " << r.valid << " good frames, " << r.invalid << " bad frames not flagged, " << s.overrunBytes
+         << " bytes lost to overrun, " << s.lostIdleEvents << " idle events lost, " << s.damagedFrames
+         << " frames flagged damaged" << endl;
+}
+
+int main() {
+    mt19937 rng(12);
+    vector<vector<uint8_t>> packets;
+    for (uint16_t seq = 0; seq < 1000; ++seq) packets.push_back(makePacket(seq, rng));
+
+    // ---- Part 1: CPU per received byte ----
+    const int kRounds = 200;
+    uint64_t bytes = 0, frames = 0, good = 0;
+    PerByteRx perByte;
+    auto start = chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round) {
+        for (const vector<uint8_t>& p : packets) {
+            for (uint8_t b : p) perByte.rxCpltCallback(b);
+            perByte.idle();
+            bytes += p.size();
+        }
+        vector<uint8_t> f;
+        while (perByte.take(f)) good += packetValid(f, f.size());
+    }
+    double perByteNs = seconds(start) * 1e9 / bytes;
+
+    uart::DmaRx rx(8192, uart::Framing::IdleLine);
+    start = chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round) {
+        for (const vector<uint8_t>& p : packets) {
+            for (size_t i = 0; i < p.size(); i += 32) rx.dmaWrite(&p[i], min<size_t>(32, p.size() - i));
+            rx.idleLine();
+            uart::Frame f;
+            if (rx.next(f, chrono::milliseconds(0))) {
+                good += packetValid(f, f.size());
+                ++frames;
+                rx.release(f);
+            }
+        }
+    }
+    double dmaNs = seconds(start) * 1e9 / bytes;
+    bool offlineOk = good == 2 * frames && rx.stats().overrunBytes == 0;
+
+    cout << fixed << setprecision(1);
+    cout << "Receive cost on " << bytes << " recorded bytes (" << frames << " packets):" << endl;
+    cout << "  interrupt per byte, copy to frame and queue: " << perByteNs << " ns/byte, " << bytes << " interrupts" << endl;
+    cout << "  DMA ring, idle events, zero-copy frames:     " << dmaNs << " ns/byte (" << perByteNs / dmaNs << "x), "
+         << rx.stats().interrupts << " interrupts" << endl;
+    cout << "  at " << setprecision(0) << kBaud / 1e6 << " Mbaud a byte arrives every " << setprecision(2)
+         << 1e9 / kBytesPerSecond << " ns; " << (offlineOk ? "all packets valid" : "INVALID packets") << endl;
+
+    // ---- Part 2: real time ----
+    vector<vector<uint8_t>> lines;
+    for (uint32_t seq = 0; seq < 1000; ++seq) {
+        string s = makeLine(seq, rng);
+        lines.emplace_back(s.begin(), s.end());
+    }
+    cout << setprecision(0) << "Real time at " << kBaud / 1e6 << " Mbaud for 1 s:" << endl;
+    RunResult idle = runRealTime(4096, uart::Framing::IdleLine, packets, 0);
+    report("idle-line framing", 4096, idle);
+    RunResult text = runRealTime(4096, uart::Framing::Delimiter, lines, 0);
+    report("delimiter framing, no gaps", 4096, text);
+    RunResult stalled = runRealTime(1024, uart::Framing::IdleLine, packets, 200);
+    report("idle-line framing, task stalls 20 ms every 200 frames", 1024, stalled);
+    bool resynced = longLineRecovers();
+
+    bool ok = offlineOk && idle.invalid == 0 && idle.stats.overrunBytes == 0 && text.invalid == 0 &&
+              text.stats.overrunBytes == 0 && stalled.invalid == 0 && stalled.stats.overrunBytes > 0 &&
+              stalled.stats.damagedFrames > 0 && resynced;
+    cout << (ok ? "every bad frame was flagged" : "UNEXPECTED result") << endl;
+    return ok ? 0 : 1;
+}
+
+
+/*Why a circular DMA buffer and idle-line framing:
+
+1. With one interrupt per byte the CPU enters and leaves the handler 300000 times a second at 3 Mbaud,
+   and the next byte must be taken from the data register before the one after it arrives (3.3 us).
+   Any longer interrupt or critical section elsewhere and the UART reports an overrun: bytes are lost.
+2. The DMA takes every byte off the register in hardware. The CPU is interrupted when the line goes idle
+   (end of a packet) or the buffer is half / completely full, a few hundred bytes per interrupt.
+3. The idle interrupt only records where the DMA is; the task finds the frame between the previous and
+   the current position. Text protocols without gaps use the delimiter instead, searched with memchr.
+4. Frames are handed out as pointers into the buffer (two pieces when a frame wraps around the end), and
+   the task releases them when done. Nothing is copied until the task decides it needs a copy.
+5. The buffer has to hold everything the task may fall behind by. When it does not, the loss is counted
+   and the frame it hit is flagged, so a damaged frame is never mistaken for a good one.
+6. With delimiter framing a buffer full of bytes without a delimiter could never be released, and every
+   later byte would be lost. It is handed out as one damaged frame instead, and framing resumes at the
+   next delimiter; the line right after it is flagged too, since bytes were lost just before it.
+*/
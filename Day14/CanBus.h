@@ -0,0 +1,345 @@
+#ifndef CAN_BUS_H
+#define CAN_BUS_H
+
+// Host-side CAN subsystem: a virtual bus, a receive ring per node, and a filter / dispatch table that hands
+// frames to subscribers in batches.
+//
+// CAN.rtl.md receives one frame per HAL_CAN_RxFifo0MsgPendingCallback and leaves filtering to the hardware
+// filter banks. A gateway on several saturated buses cannot afford a callback and a walk over a filter
+// list per frame, so here:
+//
+//     can::VirtualBus bus;                       // in-process stand-in for the wires
+//     can::FrameRing rx(1024);                   // the node's receive FIFO (lock-free, one producer / one consumer)
+//     bus.attach(rx);
+//     can::Dispatcher dispatcher;
+//     dispatcher.subscribe({can::Filter::standard(0x100, 0x7F0)}, [](const can::Frame* f, size_t n) { ... });
+//     bus.transmit(frame);                       // any thread; the bus serialises like arbitration does
+//     dispatcher.poll(rx);                       // receive thread: drain, classify, one call per subscriber
+//
+// Filters use the ID / mask scheme of the bxCAN filter banks (CAN_FILTERMODE_IDMASK): a frame matches when
+// (frameId & mask) == (id & mask). subscribe() compiles all filters into a table, so classifying a frame
+// costs the same whatever the number of filters:
+//   standard IDs (11 bit): all 2048 IDs are expanded into a bitmap of accepted IDs and a subscriber mask per ID.
+//   extended IDs (29 bit): exact IDs go into a perfect hash table (one probe, no collisions, rebuilt with a
+//   new multiplier until there are none); filters with a partial mask on an extended ID are checked one by
+//   one after that, so they should stay few.
+// Up to 64 subscribers. Subscribe before the first poll(); the table is not changed while frames flow.
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace can {
+
+const uint32_t kStandardIdCount = 2048;
+const uint32_t kStandardMask = 0x7FF;
+const uint32_t kExtendedMask = 0x1FFFFFFF;
+
+enum FrameFlags : uint8_t {
+    kExtended = 1u << 0,   // 29-bit identifier (IDE)
+    kRemote = 1u << 1,     // remote transmission request (RTR)
+};
+
+struct Frame {
+    uint32_t id;
+    uint8_t dlc;        // 0..8 data bytes
+    uint8_t flags;      // FrameFlags
+    uint8_t reserved[2];
+    uint8_t data[8];
+
+    bool extended() const { return flags & kExtended; }
+};
+static_assert(sizeof(Frame) == 16, "Frame is a compact 16-byte record");
+
+inline Frame makeFrame(uint32_t id, bool extended, const uint8_t* data, uint8_t dlc) {
+    Frame f = {};
+    f.id = id & (extended ? kExtendedMask : kStandardMask);
+    f.flags = extended ? kExtended : 0;
+    f.dlc = dlc > 8 ? 8 : dlc;
+    if (data) std::memcpy(f.data, data, f.dlc);
+    return f;
+}
+
+// Bits on the wire without stuffing (SOF, arbitration, control, data, CRC, ACK, EOF, intermission).
+inline int frameBits(const Frame& f) { return (f.extended() ? 67 : 47) + 8 * f.dlc; }
+
+// Receive FIFO of a node: a power-of-two ring for one producer (the bus) and one consumer (the receive thread).
+// Like the hardware FIFO it never blocks the bus: a frame that does not fit is dropped and counted.
+class FrameRing {
+public:
+    explicit FrameRing(size_t capacity) : frames(roundUp(capacity)), mask(frames.size() - 1) {}
+
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+
+    bool push(const Frame& f) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == frames.size()) {
+            overruns.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        frames[t & mask] = f;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Copies up to 'max' frames into 'out'; returns how many.
+    size_t pop(Frame* out, size_t max) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t available = tail.load(std::memory_order_acquire) - h;
+        size_t n = available < max ? available : max;
+        for (size_t i = 0; i < n; ++i) out[i] = frames[(h + i) & mask];
+        head.store(h + n, std::memory_order_release);
+        return n;
+    }
+
+    size_t capacity() const { return frames.size(); }
+    uint64_t overrunCount() const { return overruns.load(std::memory_order_relaxed); }
+
+private:
+    static size_t roundUp(size_t n) {
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    std::vector<Frame> frames;
+    const size_t mask;
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+    std::atomic<uint64_t> overruns{0};
+};
+
+// In-process bus: every transmitted frame reaches every attached receive ring, one frame at a time.
+class VirtualBus {
+public:
+    void attach(FrameRing& ring) {
+        std::lock_guard<std::mutex> lock(mtx);
+        receivers.push_back(&ring);
+    }
+
+    void transmit(const Frame& f) {
+        std::lock_guard<std::mutex> lock(mtx);   // arbitration: one frame on the wires at a time
+        for (FrameRing* r : receivers) r->push(f);
+        ++frameCount;
+        bitCount += frameBits(f);
+    }
+
+    void transmit(const Frame* frames, size_t n) {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (size_t i = 0; i < n; ++i) {
+            for (FrameRing* r : receivers) r->push(frames[i]);
+            bitCount += frameBits(frames[i]);
+        }
+        frameCount += n;
+    }
+
+    uint64_t frames() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return frameCount;
+    }
+    uint64_t bits() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return bitCount;
+    }
+
+private:
+    mutable std::mutex mtx;
+    std::vector<FrameRing*> receivers;
+    uint64_t frameCount = 0;
+    uint64_t bitCount = 0;
+};
+
+struct Filter {
+    uint32_t id;
+    uint32_t mask;   // 1 bits must match, 0 bits are "don't care"
+    bool extended;
+
+    static Filter standard(uint32_t id, uint32_t mask = kStandardMask) {
+        return Filter{id & kStandardMask, mask & kStandardMask, false};
+    }
+    static Filter extendedId(uint32_t id, uint32_t mask = kExtendedMask) {
+        return Filter{id & kExtendedMask, mask & kExtendedMask, true};
+    }
+
+    bool matches(const Frame& f) const { return f.extended() == extended && (f.id & mask) == (id & mask); }
+};
+
+class Dispatcher {
+public:
+    // Receives the frames of one poll() that matched the subscriber's filters, in bus order.
+    typedef std::function<void(const Frame* frames, size_t count)> Handler;
+
+    static constexpr size_t kMaxSubscribers = 64;
+    static constexpr size_t kBatch = 256;   // frames taken from a ring per round
+
+    struct Stats {
+        uint64_t frames = 0;       // classified
+        uint64_t deliveries = 0;   // frames handed to subscribers (a frame can go to several)
+        uint64_t unmatched = 0;    // no subscriber wanted it
+        uint64_t batches = 0;      // handler calls
+    };
+
+    // Returns the subscriber index, or -1 when all 64 are taken.
+    int subscribe(const std::vector<Filter>& filters, Handler handler) {
+        if (subscribers.size() == kMaxSubscribers) return -1;
+        int index = (int)subscribers.size();
+        uint64_t bit = 1ull << index;
+        subscribers.push_back(Subscriber{std::move(handler), {}});
+        subscribers.back().batch.reserve(kBatch);
+        for (const Filter& f : filters) {
+            if (!f.extended) {
+                for (uint32_t id = 0; id < kStandardIdCount; ++id) {
+                    if ((id & f.mask) == (f.id & f.mask)) {
+                        standardTargets[id] |= bit;
+                        standardAccepted[id / 64] |= 1ull << (id % 64);
+                    }
+                }
+            } else if (f.mask == kExtendedMask) {
+                exactExtended.push_back(ExactEntry{f.id, bit});
+            } else {
+                maskedExtended.push_back(MaskedEntry{f, bit});
+            }
+        }
+        buildExtendedTable();
+        return index;
+    }
+
+    // Which subscribers want frame f (bit i = subscriber i).
+    uint64_t targets(const Frame& f) const {
+        if (!f.extended()) {
+            uint32_t id = f.id & kStandardMask;
+            if (!(standardAccepted[id / 64] & (1ull << (id % 64)))) return 0;   // one word answers most misses
+            return standardTargets[id];
+        }
+        uint64_t t = 0;
+        if (!table.empty()) {
+            const ExactEntry& e = table[slotOf(f.id)];
+            if (e.mask && e.id == f.id) t = e.mask;
+        }
+        for (const MaskedEntry& m : maskedExtended) {
+            if (m.filter.matches(f)) t |= m.mask;
+        }
+        return t;
+    }
+
+    // Classifies the frames and calls every interested subscriber once with all of its frames.
+    void dispatch(const Frame* frames, size_t n) {
+        uint64_t touched = 0;
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t t = targets(frames[i]);
+            if (!t) {
+                ++counters.unmatched;
+                continue;
+            }
+            touched |= t;
+            while (t) {
+                int s = __builtin_ctzll(t);
+                t &= t - 1;
+                subscribers[s].batch.push_back(frames[i]);
+                ++counters.deliveries;
+            }
+        }
+        counters.frames += n;
+        while (touched) {
+            int s = __builtin_ctzll(touched);
+            touched &= touched - 1;
+            Subscriber& sub = subscribers[s];
+            sub.handler(sub.batch.data(), sub.batch.size());
+            sub.batch.clear();
+            ++counters.batches;
+        }
+    }
+
+    // Drains the ring in rounds of kBatch frames; returns the number of frames taken.
+    size_t poll(FrameRing& ring) {
+        size_t total = 0;
+        while (size_t n = ring.pop(scratch, kBatch)) {
+            dispatch(scratch, n);
+            total += n;
+        }
+        return total;
+    }
+
+    const Stats& stats() const { return counters; }
+    size_t subscriberCount() const { return subscribers.size(); }
+
+private:
+    struct Subscriber {
+        Handler handler;
+        std::vector<Frame> batch;   // frames of the current dispatch() for this subscriber
+    };
+
+    struct ExactEntry {
+        uint32_t id;
+        uint64_t mask;   // 0: empty slot
+    };
+
+    struct MaskedEntry {
+        Filter filter;
+        uint64_t mask;
+    };
+
+    size_t slotOf(uint32_t id) const { return (size_t)((uint32_t)(id * multiplier) >> shift); }
+
+    // Perfect hash for the exact extended IDs: a table of at least twice their number and a multiplier with
+    // which no two IDs share a slot. If a few hundred multipliers all collide, the table doubles.
+    void buildExtendedTable() {
+        std::vector<ExactEntry> ids;   // merge subscribers that asked for the same ID
+        for (const ExactEntry& e : exactExtended) {
+            bool merged = false;
+            for (ExactEntry& m : ids) {
+                if (m.id == e.id) {
+                    m.mask |= e.mask;
+                    merged = true;
+                }
+            }
+            if (!merged) ids.push_back(e);
+        }
+        table.clear();
+        if (ids.empty()) return;
+
+        int bits = 1;
+        while ((1u << bits) < 2 * ids.size()) ++bits;
+        uint32_t candidate = 0x9E3779B1u;   // golden-ratio multiplier first, then odd numbers from an LCG
+        for (;; ++bits) {
+            shift = 32 - bits;
+            for (int attempt = 0; attempt < 256; ++attempt) {
+                multiplier = candidate | 1;
+                candidate = candidate * 1664525u + 1013904223u;
+                std::vector<ExactEntry> t(1u << bits, ExactEntry{0, 0});
+                bool collision = false;
+                for (const ExactEntry& e : ids) {
+                    ExactEntry& slot = t[slotOf(e.id)];
+                    if (slot.mask) {
+                        collision = true;
+                        break;
+                    }
+                    slot = e;
+                }
+                if (!collision) {
+                    table.swap(t);
+                    return;
+                }
+            }
+        }
+    }
+
+    std::vector<Subscriber> subscribers;
+    uint64_t standardTargets[kStandardIdCount] = {};
+    uint64_t standardAccepted[kStandardIdCount / 64] = {};
+    std::vector<ExactEntry> exactExtended;    // as subscribed
+    std::vector<ExactEntry> table;            // perfect hash of exactExtended
+    uint32_t multiplier = 0;
+    int shift = 32;
+    std::vector<MaskedEntry> maskedExtended;
+    Frame scratch[kBatch];
+    Stats counters;
+};
+
+} // namespace can
+
+#endif // CAN_BUS_H
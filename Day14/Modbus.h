@@ -0,0 +1,382 @@
+#ifndef MODBUS_H
+#define MODBUS_H
+
+// Modbus RTU / TCP codec for the host: frame encoding and decoding, a slave that answers from a register
+// map, and a read planner for the master.
+//
+// chatgpt14.md polls with ModbusMaster one transaction per call, and a master that asks for every register
+// separately pays a full round trip (request, silence, turnaround, response, silence) per register.
+// Here the master plans its reads:
+//
+//     std::vector<modbus::ReadBlock> plan = modbus::coalesceReads(unit, modbus::kReadHolding, wanted);
+//     for (const modbus::ReadBlock& b : plan) {
+//         size_t n = modbus::encodeRead(modbus::Transport::Rtu, 0, b.unit, b.function, b.address, b.count, tx, sizeof tx);
+//         ... send tx, receive rx ...
+//         modbus::Status s = modbus::decodeReadResponse(modbus::Transport::Rtu, rx, rxLength, 0, b, values);
+//     }
+//
+// and a slave serves requests straight from its map:
+//
+//     modbus::RegisterMap map(0, 200, 0, 100);          // holding 0..199, input 0..99
+//     modbus::Slave slave(17, map);
+//     size_t reply = slave.handle(modbus::Transport::Rtu, rx, rxLength, tx, sizeof tx);   // 0: no reply
+//
+// - CRC16 (polynomial 0xA001, init 0xFFFF) uses slicing-by-8: eight 256-entry tables, one step per 8 bytes
+//   instead of per byte. crc16Bytewise() is the classic table-per-byte version, kept as the reference.
+// - The register map keeps every table in wire format (big-endian, 2 bytes per register) in one contiguous
+//   array, so a read of N registers is one memcpy into the reply and a write of N registers one memcpy out
+//   of the request; nothing is converted register by register.
+// - coalesceReads() merges wanted addresses into the fewest read requests of at most 125 registers, also
+//   across small gaps (reading a few unwanted registers is cheaper than another round trip). Use maxGap 0
+//   for devices that reject reads of unmapped registers.
+// - Nothing here allocates per frame: encoding and decoding work in caller buffers, decoded requests point
+//   into the received frame.
+//
+// Function codes: 0x03 read holding, 0x04 read input, 0x06 write single, 0x10 write multiple registers.
+// Other codes are answered with exception 0x01. Unit 0 is broadcast: writes are executed, nothing is answered.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace modbus {
+
+enum class Transport { Rtu, Tcp };
+
+enum FunctionCode : uint8_t {
+    kReadHolding = 0x03,
+    kReadInput = 0x04,
+    kWriteSingle = 0x06,
+    kWriteMultiple = 0x10,
+};
+
+enum ExceptionCode : uint8_t {
+    kIllegalFunction = 0x01,
+    kIllegalAddress = 0x02,
+    kIllegalValue = 0x03,
+};
+
+enum class Status {
+    Ok,
+    Incomplete,   // shorter than the header says / than a minimal frame
+    BadCrc,       // RTU checksum wrong
+    BadHeader,    // TCP protocol id or length wrong
+    Exception,    // the slave answered with an exception code
+    Mismatch,     // a valid frame, but not the answer to this request
+};
+
+const size_t kMaxAdu = 260;         // TCP: 7-byte MBAP header + 253-byte PDU (RTU: 256)
+const uint16_t kMaxReadCount = 125;
+const uint16_t kMaxWriteCount = 123;
+
+// ---- CRC16 ----
+
+struct CrcTables {
+    uint16_t t[8][256];   // t[k][b]: CRC contribution of byte b followed by k zero bytes
+
+    CrcTables() {
+        for (int b = 0; b < 256; ++b) {
+            uint16_t crc = (uint16_t)b;
+            for (int bit = 0; bit < 8; ++bit) crc = (crc & 1) ? (uint16_t)((crc >> 1) ^ 0xA001) : (uint16_t)(crc >> 1);
+            t[0][b] = crc;
+        }
+        for (int k = 1; k < 8; ++k) {
+            for (int b = 0; b < 256; ++b) t[k][b] = (uint16_t)((t[k - 1][b] >> 8) ^ t[0][t[k - 1][b] & 0xFF]);
+        }
+    }
+};
+
+inline const CrcTables& crcTables() {
+    static const CrcTables tables;
+    return tables;
+}
+
+inline uint16_t crc16Bytewise(const uint8_t* p, size_t n, uint16_t crc = 0xFFFF) {
+    const uint16_t* t = crcTables().t[0];
+    while (n--) crc = (uint16_t)((crc >> 8) ^ t[(crc ^ *p++) & 0xFF]);
+    return crc;
+}
+
+inline uint16_t crc16(const uint8_t* p, size_t n, uint16_t crc = 0xFFFF) {
+    const CrcTables& c = crcTables();
+    while (n >= 8) {
+        uint32_t x = crc ^ (p[0] | (uint32_t)p[1] << 8);   // the CRC folds into the first two bytes
+        crc = (uint16_t)(c.t[7][x & 0xFF] ^ c.t[6][x >> 8] ^ c.t[5][p[2]] ^ c.t[4][p[3]] ^ c.t[3][p[4]] ^
+                         c.t[2][p[5]] ^ c.t[1][p[6]] ^ c.t[0][p[7]]);
+        p += 8;
+        n -= 8;
+    }
+    return crc16Bytewise(p, n, crc);
+}
+
+// ---- Framing ----
+
+inline uint16_t get16(const uint8_t* p) { return (uint16_t)(p[0] << 8 | p[1]); }
+inline void put16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+// Bytes in front of the PDU: unit id (RTU), MBAP header (TCP).
+inline size_t headerSize(Transport t) { return t == Transport::Rtu ? 1 : 7; }
+inline size_t trailerSize(Transport t) { return t == Transport::Rtu ? 2 : 0; }
+
+// A received frame, split up. 'pdu' points into the frame.
+struct Adu {
+    uint16_t transaction = 0;   // TCP only
+    uint8_t unit = 0;
+    const uint8_t* pdu = nullptr;
+    size_t pduLength = 0;
+};
+
+// Writes header and trailer around a PDU of 'pduLength' bytes already at out + headerSize(t).
+inline size_t finishAdu(Transport t, uint16_t transaction, uint8_t unit, uint8_t* out, size_t pduLength) {
+    if (t == Transport::Rtu) {
+        out[0] = unit;
+        uint16_t crc = crc16(out, 1 + pduLength);
+        out[1 + pduLength] = (uint8_t)crc;          // CRC is sent low byte first
+        out[2 + pduLength] = (uint8_t)(crc >> 8);
+        return 3 + pduLength;
+    }
+    put16(out, transaction);
+    put16(out + 2, 0);                              // protocol id
+    put16(out + 4, (uint16_t)(pduLength + 1));      // unit id + PDU
+    out[6] = unit;
+    return 7 + pduLength;
+}
+
+inline Status parseAdu(Transport t, const uint8_t* frame, size_t n, Adu& adu) {
+    if (t == Transport::Rtu) {
+        if (n < 4) return Status::Incomplete;
+        uint16_t crc = crc16(frame, n - 2);
+        if (frame[n - 2] != (uint8_t)crc || frame[n - 1] != (uint8_t)(crc >> 8)) return Status::BadCrc;
+        adu.unit = frame[0];
+        adu.pdu = frame + 1;
+        adu.pduLength = n - 3;
+        return Status::Ok;
+    }
+    if (n < 8) return Status::Incomplete;
+    if (get16(frame + 2) != 0) return Status::BadHeader;
+    size_t length = get16(frame + 4);
+    if (length < 2 || length > kMaxAdu - 6) return Status::BadHeader;
+    if (n < 6 + length) return Status::Incomplete;
+    adu.transaction = get16(frame);
+    adu.unit = frame[6];
+    adu.pdu = frame + 7;
+    adu.pduLength = length - 1;
+    return Status::Ok;
+}
+
+// ---- Master side ----
+
+inline size_t encodeRead(Transport t, uint16_t transaction, uint8_t unit, uint8_t function, uint16_t address,
+                         uint16_t count, uint8_t* out, size_t capacity) {
+    if (capacity < headerSize(t) + 5 + trailerSize(t)) return 0;
+    uint8_t* pdu = out + headerSize(t);
+    pdu[0] = function;
+    put16(pdu + 1, address);
+    put16(pdu + 3, count);
+    return finishAdu(t, transaction, unit, out, 5);
+}
+
+inline size_t encodeWriteSingle(Transport t, uint16_t transaction, uint8_t unit, uint16_t address, uint16_t value,
+                                uint8_t* out, size_t capacity) {
+    if (capacity < headerSize(t) + 5 + trailerSize(t)) return 0;
+    uint8_t* pdu = out + headerSize(t);
+    pdu[0] = kWriteSingle;
+    put16(pdu + 1, address);
+    put16(pdu + 3, value);
+    return finishAdu(t, transaction, unit, out, 5);
+}
+
+inline size_t encodeWriteMultiple(Transport t, uint16_t transaction, uint8_t unit, uint16_t address,
+                                  const uint16_t* values, uint16_t count, uint8_t* out, size_t capacity) {
+    size_t pduLength = 6 + 2 * (size_t)count;
+    if (count == 0 || count > kMaxWriteCount || capacity < headerSize(t) + pduLength + trailerSize(t)) return 0;
+    uint8_t* pdu = out + headerSize(t);
+    pdu[0] = kWriteMultiple;
+    put16(pdu + 1, address);
+    put16(pdu + 3, count);
+    pdu[5] = (uint8_t)(2 * count);
+    for (uint16_t i = 0; i < count; ++i) put16(pdu + 6 + 2 * i, values[i]);
+    return finishAdu(t, transaction, unit, out, pduLength);
+}
+
+struct ReadBlock {
+    uint8_t unit;
+    uint8_t function;   // kReadHolding or kReadInput
+    uint16_t address;
+    uint16_t count;
+};
+
+// Checks the reply to 'block' (sent with 'transaction', TCP only) and copies the register values into
+// values[0 .. block.count). On Status::Exception, *exception (if given) receives the exception code.
+inline Status decodeReadResponse(Transport t, const uint8_t* frame, size_t n, uint16_t transaction,
+                                 const ReadBlock& block, uint16_t* values, uint8_t* exception = nullptr) {
+    Adu adu;
+    Status s = parseAdu(t, frame, n, adu);
+    if (s != Status::Ok) return s;
+    if (adu.unit != block.unit || adu.transaction != transaction || adu.pduLength < 2) return Status::Mismatch;
+    if (adu.pdu[0] == (block.function | 0x80)) {
+        if (exception) *exception = adu.pdu[1];
+        return Status::Exception;
+    }
+    if (adu.pdu[0] != block.function || adu.pdu[1] != 2 * block.count || adu.pduLength != 2 + 2 * (size_t)block.count) {
+        return Status::Mismatch;
+    }
+    for (uint16_t i = 0; i < block.count; ++i) values[i] = get16(adu.pdu + 2 + 2 * i);
+    return Status::Ok;
+}
+
+// Fewest read requests covering every address in 'addresses' (any order, duplicates allowed). Two wanted
+// addresses share a request when at most 'maxGap' unwanted registers lie between them and the request stays
+// within 'maxCount' registers.
+inline std::vector<ReadBlock> coalesceReads(uint8_t unit, uint8_t function, std::vector<uint16_t> addresses,
+                                            uint16_t maxGap = 8, uint16_t maxCount = kMaxReadCount) {
+    std::vector<ReadBlock> blocks;
+    std::sort(addresses.begin(), addresses.end());
+    addresses.erase(std::unique(addresses.begin(), addresses.end()), addresses.end());
+    for (uint16_t a : addresses) {
+        if (!blocks.empty()) {
+            ReadBlock& last = blocks.back();
+            uint32_t end = (uint32_t)last.address + last.count;   // first address after the block
+            if (a - end <= maxGap && a - last.address + 1u <= maxCount) {
+                last.count = (uint16_t)(a - last.address + 1);
+                continue;
+            }
+        }
+        blocks.push_back(ReadBlock{unit, function, a, 1});
+    }
+    return blocks;
+}
+
+// ---- Slave side ----
+
+class RegisterMap {
+public:
+    RegisterMap(uint16_t holdingBase, uint16_t holdingCount, uint16_t inputBase, uint16_t inputCount)
+        : holdingTable{holdingBase, std::vector<uint8_t>(2 * (size_t)holdingCount)},
+          inputTable{inputBase, std::vector<uint8_t>(2 * (size_t)inputCount)} {}
+
+    // Application access to single registers; the address must be inside the table.
+    uint16_t holding(uint16_t address) const { return get16(holdingTable.at(address)); }
+    uint16_t input(uint16_t address) const { return get16(inputTable.at(address)); }
+    void setHolding(uint16_t address, uint16_t v) { put16(holdingTable.at(address), v); }
+    void setInput(uint16_t address, uint16_t v) { put16(inputTable.at(address), v); }
+
+    // Registers [address, address + count) of a table in wire format, or nullptr if not all of them exist.
+    const uint8_t* wire(uint8_t function, uint16_t address, uint16_t count) const {
+        const Table& t = function == kReadInput ? inputTable : holdingTable;
+        return t.covers(address, count) ? t.at(address) : nullptr;
+    }
+    uint8_t* holdingWire(uint16_t address, uint16_t count) {
+        return holdingTable.covers(address, count) ? holdingTable.at(address) : nullptr;
+    }
+
+private:
+    struct Table {
+        uint16_t base;
+        std::vector<uint8_t> bytes;
+
+        bool covers(uint16_t address, uint16_t count) const {
+            return address >= base && (size_t)(address - base) + count <= bytes.size() / 2;
+        }
+        uint8_t* at(uint16_t address) { return &bytes[2 * (size_t)(address - base)]; }
+        const uint8_t* at(uint16_t address) const { return &bytes[2 * (size_t)(address - base)]; }
+    };
+
+    Table holdingTable;
+    Table inputTable;
+};
+
+class Slave {
+public:
+    Slave(uint8_t unit, RegisterMap& map) : unit(unit), map(map) {}
+
+    struct Stats {
+        uint64_t requests = 0;
+        uint64_t exceptions = 0;
+        uint64_t dropped = 0;   // bad CRC, bad header or not for this unit
+    };
+
+    // Serves one request frame. Returns the length of the reply in 'out' (at least kMaxAdu bytes),
+    // 0 if there is nothing to send.
+    size_t handle(Transport t, const uint8_t* frame, size_t n, uint8_t* out, size_t capacity) {
+        Adu adu;
+        if (parseAdu(t, frame, n, adu) != Status::Ok || (adu.unit != unit && adu.unit != 0) || adu.pduLength < 1 ||
+            capacity < kMaxAdu) {
+            ++counters.dropped;
+            return 0;
+        }
+        ++counters.requests;
+        bool broadcast = adu.unit == 0;
+        const uint8_t* req = adu.pdu;
+        uint8_t* reply = out + headerSize(t);
+        uint8_t function = req[0];
+        size_t replyLength = 0;
+        uint8_t exception = 0;
+
+        switch (function) {
+        case kReadHolding:
+        case kReadInput: {
+            if (adu.pduLength != 5) { exception = kIllegalValue; break; }
+            uint16_t address = get16(req + 1), count = get16(req + 3);
+            if (count == 0 || count > kMaxReadCount) { exception = kIllegalValue; break; }
+            const uint8_t* registers = map.wire(function, address, count);
+            if (!registers) { exception = kIllegalAddress; break; }
+            reply[0] = function;
+            reply[1] = (uint8_t)(2 * count);
+            std::memcpy(reply + 2, registers, 2 * (size_t)count);   // already big-endian
+            replyLength = 2 + 2 * (size_t)count;
+            break;
+        }
+        case kWriteSingle: {
+            if (adu.pduLength != 5) { exception = kIllegalValue; break; }
+            uint8_t* target = map.holdingWire(get16(req + 1), 1);
+            if (!target) { exception = kIllegalAddress; break; }
+            std::memcpy(target, req + 3, 2);
+            std::memcpy(reply, req, 5);   // the reply echoes the request
+            replyLength = 5;
+            break;
+        }
+        case kWriteMultiple: {
+            if (adu.pduLength < 6) { exception = kIllegalValue; break; }
+            uint16_t address = get16(req + 1), count = get16(req + 3);
+            if (count == 0 || count > kMaxWriteCount || req[5] != 2 * count || adu.pduLength != 6 + 2 * (size_t)count) {
+                exception = kIllegalValue;
+                break;
+            }
+            uint8_t* target = map.holdingWire(address, count);
+            if (!target) { exception = kIllegalAddress; break; }
+            std::memcpy(target, req + 6, 2 * (size_t)count);
+            std::memcpy(reply, req, 5);
+            replyLength = 5;
+            break;
+        }
+        default:
+            exception = kIllegalFunction;
+        }
+
+        if (broadcast) return 0;
+        if (exception) {
+            ++counters.exceptions;
+            reply[0] = (uint8_t)(function | 0x80);
+            reply[1] = exception;
+            replyLength = 2;
+        }
+        return finishAdu(t, adu.transaction, unit, out, replyLength);
+    }
+
+    const Stats& stats() const { return counters; }
+
+private:
+    uint8_t unit;
+    RegisterMap& map;
+    Stats counters;
+};
+
+} // namespace modbus
+
+#endif // MODBUS_H
@@ -0,0 +1,228 @@
+// A CAN gateway on the host with CanBus.h. The subscribers are typical for a vehicle gateway: engine, brake
+// and body frames, diagnostics, a routing table of 32 IDs and J1939 messages on extended IDs, 43 filters
+// in total.
+// Part 1 pushes 2 million recorded frames through a per-frame linear filter walk (one callback per frame
+// and match, as with HAL callbacks) and through the compiled table with batched delivery, and checks that
+// every subscriber saw the same frames.
+// Part 2 runs three saturated 1 Mbit/s buses in real time for one second, one transmit thread each, and
+// a gateway thread that polls the three receive rings.
+//     g++ -std=c++17 -O2 -pthread challeng14_1.cpp -o challeng14_1
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include "CanBus.h"
+
+using namespace std;
+
+struct Received {   // what a subscriber keeps: enough to prove both paths delivered the same frames
+    uint64_t frames = 0;
+    uint64_t checksum = 0;
+
+    void add(const can::Frame& f) {
+        ++frames;
+        checksum = checksum * 31 + f.id + f.data[0] + f.data[7];
+    }
+};
+
+struct Subscription {
+    const char* name;
+    vector<can::Filter> filters;
+};
+
+vector<Subscription> gatewaySubscriptions() {
+    vector<Subscription> subs = {
+        {"engine", {can::Filter::standard(0x100, 0x7F0)}},
+        {"brakes", {can::Filter::standard(0x200), can::Filter::standard(0x201), can::Filter::standard(0x202)}},
+        {"body", {can::Filter::standard(0x300, 0x700)}},
+        {"diagnostics", {can::Filter::standard(0x7E0, 0x7F0)}},
+        {"j1939 engine", {can::Filter::extendedId(0x0CF00400), can::Filter::extendedId(0x18FEEE00),
+                          can::Filter::extendedId(0x18FEF200), can::Filter::extendedId(0x18FEF100)}},
+        {"j1939 DM1", {can::Filter::extendedId(0x18FECA00, 0x03FFFF00)}},   // DM1 from any source address
+        {"routing", {}},
+    };
+    for (int i = 0; i < 32; ++i) subs.back().filters.push_back(can::Filter::standard(0x400 + 3 * i));
+    return subs;
+}
+
+vector<can::Frame> recordTraffic(size_t n, uint32_t seed) {
+    mt19937 rng(seed);
+    vector<can::Frame> frames(n);
+    for (can::Frame& f : frames) {
+        uint8_t data[8];
+        for (uint8_t& b : data) b = (uint8_t)rng();
+        int kind = rng() % 100;
+        uint32_t id;
+        bool extended = false;
+        if (kind < 30) id = 0x100 + rng() % 16;                         // engine
+        else if (kind < 40) id = 0x200 + rng() % 4;                     // brakes (0x203 is not subscribed)
+        else if (kind < 55) id = 0x300 + rng() % 256;                   // body
+        else if (kind < 60) id = 0x7E0 + rng() % 16;                    // diagnostics
+        else if (kind < 70) id = 0x400 + rng() % 128;                   // routed and not routed
+        else if (kind < 75) id = rng() % 2048;                          // anything
+        else {
+            extended = true;
+            static const uint32_t pgns[] = {0x0CF00400, 0x18FEEE00, 0x18FEF200, 0x18FEF100, 0x18FEF500, 0x18FEE900};
+            if (kind < 90) id = pgns[rng() % 6] | rng() % 4;            // source addresses 0..3, only 0 subscribed
+            else id = 0x18FECA00 | (rng() % 256);                       // DM1 from any node
+        }
+        f = can::makeFrame(id, extended, data, (uint8_t)(1 + rng() % 8));
+    }
+    return frames;
+}
+
+// What the application does without the table: walk the filter list for every frame and call back per frame.
+struct LinearDispatcher {
+    struct Entry {
+        can::Filter filter;
+        int subscriber;
+    };
+    vector<Entry> filters;
+    vector<function<void(const can::Frame&)>> handlers;
+
+    void dispatch(const can::Frame& f) {
+        uint64_t delivered = 0;   // a frame matching two filters of one subscriber is delivered once
+        for (const Entry& e : filters) {
+            if (e.filter.matches(f) && !(delivered & (1ull << e.subscriber))) {
+                delivered |= 1ull << e.subscriber;
+                handlers[e.subscriber](f);
+            }
+        }
+    }
+};
+
+double seconds(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+    vector<Subscription> subs = gatewaySubscriptions();
+    size_t filterCount = 0;
+    for (const Subscription& s : subs) filterCount += s.filters.size();
+    vector<can::Frame> traffic = recordTraffic(2000000, 14);
+
+    // ---- Part 1: the same recording through both dispatchers ----
+    vector<Received> linearSeen(subs.size()), tableSeen(subs.size());
+
+    LinearDispatcher linear;
+    for (size_t s = 0; s < subs.size(); ++s) {
+        for (const can::Filter& f : subs[s].filters) linear.filters.push_back({f, (int)s});
+        linear.handlers.push_back([&linearSeen, s](const can::Frame& f) { linearSeen[s].add(f); });
+    }
+    can::Dispatcher table;
+    for (size_t s = 0; s < subs.size(); ++s) {
+        table.subscribe(subs[s].filters, [&tableSeen, s](const can::Frame* f, size_t n) {
+            for (size_t i = 0; i < n; ++i) tableSeen[s].add(f[i]);
+        });
+    }
+
+    auto start = chrono::steady_clock::now();
+    for (const can::Frame& f : traffic) linear.dispatch(f);
+    double linearNs = seconds(start) * 1e9 / traffic.size();
+
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < traffic.size(); i += can::Dispatcher::kBatch) {
+        table.dispatch(&traffic[i], min(can::Dispatcher::kBatch, traffic.size() - i));
+    }
+    double tableNs = seconds(start) * 1e9 / traffic.size();
+
+    bool same = true;
+    for (size_t s = 0; s < subs.size(); ++s) {
+        same = same && linearSeen[s].frames == tableSeen[s].frames && linearSeen[s].checksum == tableSeen[s].checksum;
+    }
+    const can::Dispatcher::Stats& st = table.stats();
+    cout << fixed << setprecision(1);
+    cout << subs.size() << " subscribers, " << filterCount << " filters, " << traffic.size() << " frames" << endl;
+    cout << "  linear filter list, callback per frame: " << linearNs << " ns/frame" << endl;
+    cout << "  filter table, batched delivery:         " << tableNs << " ns/frame (" << linearNs / tableNs
+         << "x), " << (double)st.deliveries / st.batches << " frames per handler call" << endl;
+    cout << "  " << st.unmatched << " frames matched no filter; deliveries "
+         << (same ? "identical" : "DIFFERENT") << endl;
+
+    // ---- Part 2: three saturated buses in real time ----
+    const int kBuses = 3;
+    const double kBitrate = 1e6;
+    can::VirtualBus buses[kBuses];
+    vector<unique_ptr<can::FrameRing>> rings;
+    for (int b = 0; b < kBuses; ++b) {
+        rings.emplace_back(new can::FrameRing(1024));   // about 100 ms of one bus
+        buses[b].attach(*rings.back());
+    }
+    vector<Received> gatewaySeen(subs.size());
+    can::Dispatcher gateway;
+    for (size_t s = 0; s < subs.size(); ++s) {
+        gateway.subscribe(subs[s].filters, [&gatewaySeen, s](const can::Frame* f, size_t n) {
+            for (size_t i = 0; i < n; ++i) gatewaySeen[s].add(f[i]);
+        });
+    }
+
+    atomic<bool> running{true};
+    double busyS = 0;
+    thread gatewayThread([&] {
+        while (running.load(memory_order_acquire)) {
+            auto t = chrono::steady_clock::now();
+            size_t n = 0;
+            for (auto& r : rings) n += gateway.poll(*r);
+            if (n) busyS += seconds(t);
+            else this_thread::sleep_for(chrono::microseconds(200));   // a receive interrupt would wake it instead
+        }
+        for (auto& r : rings) gateway.poll(*r);
+    });
+
+    vector<thread> transmitters;
+    auto busStart = chrono::steady_clock::now();
+    for (int b = 0; b < kBuses; ++b) {
+        transmitters.emplace_back([&, b] {
+            vector<can::Frame> frames = recordTraffic(20000, 100 + b);
+            size_t next = 0;
+            double busTime = 0;   // seconds of wire time used so far
+            while (busTime < 1.0 && next < frames.size()) {
+                // Put the frames of the next millisecond on the wire, back to back.
+                size_t first = next;
+                while (next < frames.size() && busTime < (chrono::duration<double>(chrono::steady_clock::now() -
+                                                                                   busStart).count() + 0.001)) {
+                    busTime += frameBits(frames[next++]) / kBitrate;
+                }
+                buses[b].transmit(&frames[first], next - first);
+                this_thread::sleep_until(busStart + chrono::duration_cast<chrono::steady_clock::duration>(
+                                                        chrono::duration<double>(busTime)));
+            }
+        });
+    }
+    for (thread& t : transmitters) t.join();
+    double elapsed = seconds(busStart);
+    running.store(false, memory_order_release);
+    gatewayThread.join();
+
+    uint64_t sent = 0, overruns = 0;
+    for (int b = 0; b < kBuses; ++b) {
+        sent += buses[b].frames();
+        overruns += rings[b]->overrunCount();
+    }
+    cout << kBuses << " buses at " << kBitrate / 1e6 << " Mbit/s, 100% load for " << elapsed << " s: " << sent
+         << " frames (" << sent / elapsed << " frames/s), " << overruns << " FIFO overruns" << endl;
+    cout << "  gateway busy " << setprecision(2) << 100 * busyS / elapsed << "% of one core; the table could classify the traffic of about "
+         << setprecision(0) << 1e9 / tableNs / (sent / elapsed / kBuses) << " such buses" << endl;
+    return same && overruns == 0 ? 0 : 1;
+}
+
+
+/*Why a compiled filter table and batches:
+
+1. A linear filter list costs one comparison per filter per frame, and a gateway has dozens of filters.
+   The table answers with one bitmap word and one array entry for standard IDs, and one hash probe for
+   exact extended IDs, whatever the number of filters.
+2. All 2048 standard IDs fit into a 256-byte bitmap (plus a subscriber mask per ID), so expanding every
+   ID/mask filter at subscribe time is cheap. Extended IDs (29 bits) are too many for that; exact ones go
+   into a perfect hash table, which never needs a second probe.
+3. Batches: a subscriber gets all of its frames of one round in one call, in bus order, from a contiguous
+   array. Handler calls and cache misses on the handler's state drop by the batch size.
+4. The receive ring never blocks the bus, like the controller's FIFO: if the gateway falls behind, frames are
+   lost and counted as overruns. Being fast enough is the only way not to lose frames.
+*/
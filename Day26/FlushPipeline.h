@@ -0,0 +1,209 @@
+#ifndef FLUSH_PIPELINE_H
+#define FLUSH_PIPELINE_H
+
+// Pipelined strip flushing for an LVGL-style display driver, with a simulated DMA transfer on the host.
+//
+// LVGL.cpp gives LVGL a single draw buffer (buf[LV_HOR_RES_MAX * 10]). LVGL renders a strip into it, calls
+// my_disp_flush and must wait until the strip has been sent before it can render the next strip into the
+// same memory, so the CPU and the bus take turns. With two or more buffers the CPU renders the next strip
+// while the previous one is still on the bus:
+//
+//     gfx::FlushPipeline pipeline(panel, 240, 20, 2);    // 240 px wide strips of 20 lines, 2 buffers
+//     gfx::DrawBuffer* buf = pipeline.acquire();          // waits only if every buffer is still being sent
+//     ... render the strip into buf->pixels ...
+//     pipeline.flush(buf, area, lastStripOfFrame);        // returns at once; the transfer runs in the background
+//
+// On the device, flush() is where my_disp_flush starts the SPI DMA, and the DMA-complete interrupt calls
+// lv_disp_flush_ready(), which here is transferDone(). On the host a worker thread plays the DMA: it copies
+// the strip into a DisplaySink and takes as long as the bus would (bytes / busBytesPerSecond).
+//
+// statistics() reports frame times (from one frame on the panel to the next), how long the renderer was
+// busy, stalled waiting for a buffer, and how much of rendering and transfer ran at the same time.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Framebuffer.h"
+
+namespace gfx {
+
+struct DrawBuffer {
+    std::vector<uint16_t> pixels;   // width * linesPerBuffer, rows are 'width' pixels apart
+    int index;
+};
+
+struct PipelineStats {
+    size_t frames = 0;
+    double frameMsMedian = 0, frameMsP99 = 0, frameMsMax = 0;
+    double fps = 0;
+    double renderMs = 0;     // renderer busy (between acquire() and flush())
+    double stallMs = 0;      // renderer waiting in acquire() for a free buffer
+    double transferMs = 0;   // bus busy
+    double wallMs = 0;       // first acquire() to the last strip on the panel
+    double overlapMs = 0;    // rendering and transferring at the same time
+};
+
+class FlushPipeline {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    FlushPipeline(DisplaySink& sink, int width, int linesPerBuffer, int bufferCount, double busBytesPerSecond = 5e6)
+        : sink(sink), width(width), lines(linesPerBuffer), busBytesPerSecond(busBytesPerSecond) {
+        for (int i = 0; i < bufferCount; ++i) {
+            buffers.push_back(DrawBuffer{std::vector<uint16_t>((size_t)width * linesPerBuffer), i});
+        }
+        for (DrawBuffer& b : buffers) freeBuffers.push_back(&b);
+        worker = std::thread(&FlushPipeline::dmaLoop, this);
+    }
+
+    ~FlushPipeline() {
+        waitIdle();
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stop = true;
+        }
+        transferReady.notify_one();
+        worker.join();
+    }
+
+    FlushPipeline(const FlushPipeline&) = delete;
+    FlushPipeline& operator=(const FlushPipeline&) = delete;
+
+    int bufferLines() const { return lines; }
+
+    // Renderer: returns a buffer that is not being transferred, waiting for one if necessary.
+    DrawBuffer* acquire() {
+        Clock::time_point start = Clock::now();
+        std::unique_lock<std::mutex> lock(mtx);
+        if (!started) {
+            started = true;
+            firstAcquire = start;
+        }
+        bufferFree.wait(lock, [this] { return !freeBuffers.empty(); });
+        DrawBuffer* b = freeBuffers.front();
+        freeBuffers.pop_front();
+        Clock::time_point now = Clock::now();
+        stallTime += now - start;
+        renderStart = now;
+        return b;
+    }
+
+    // Renderer: queues the strip 'area' (at most width x linesPerBuffer pixels) for transfer and returns.
+    void flush(DrawBuffer* buffer, const Rect& area, bool lastOfFrame) {
+        Clock::time_point now = Clock::now();
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            renderTime += now - renderStart;
+            transfers.push_back(Transfer{buffer, area, lastOfFrame});
+        }
+        transferReady.notify_one();
+    }
+
+    // Blocks until every queued strip is on the panel.
+    void waitIdle() {
+        std::unique_lock<std::mutex> lock(mtx);
+        bufferFree.wait(lock, [this] { return transfers.empty() && !transferring; });
+    }
+
+    PipelineStats statistics() {
+        waitIdle();
+        std::lock_guard<std::mutex> lock(mtx);
+        PipelineStats s;
+        auto ms = [](Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+        s.frames = framePresented.size();
+        s.renderMs = ms(renderTime);
+        s.stallMs = ms(stallTime);
+        s.transferMs = ms(transferTime);
+        if (!framePresented.empty()) s.wallMs = ms(framePresented.back() - firstAcquire);
+        // The renderer is always either rendering or stalled, and the pipeline runs until the last transfer,
+        // so whatever render + transfer time does not fit into the wall time ran in parallel.
+        s.overlapMs = std::max(0.0, s.renderMs + s.transferMs - s.wallMs);
+
+        std::vector<double> frameMs;
+        Clock::time_point previous = firstAcquire;
+        for (Clock::time_point t : framePresented) {
+            frameMs.push_back(ms(t - previous));
+            previous = t;
+        }
+        if (!frameMs.empty()) {
+            std::sort(frameMs.begin(), frameMs.end());
+            s.frameMsMedian = frameMs[frameMs.size() / 2];
+            s.frameMsP99 = frameMs[std::min(frameMs.size() - 1, (size_t)(frameMs.size() * 0.99))];
+            s.frameMsMax = frameMs.back();
+            s.fps = s.frames / (s.wallMs / 1000);
+        }
+        return s;
+    }
+
+private:
+    struct Transfer {
+        DrawBuffer* buffer;
+        Rect area;
+        bool lastOfFrame;
+    };
+
+    // Plays the DMA controller: one strip at a time, as long as the bus needs for it.
+    void dmaLoop() {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true) {
+            transferReady.wait(lock, [this] { return stop || !transfers.empty(); });
+            if (transfers.empty()) return;   // stop, and nothing left to send
+            Transfer t = transfers.front();
+            transfers.pop_front();
+            transferring = true;
+            lock.unlock();
+
+            Clock::time_point start = Clock::now();
+            sink.write(t.area, t.buffer->pixels.data(), width);
+            double seconds = t.area.area() * 2 / busBytesPerSecond;
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(
+                                                      std::chrono::duration<double>(seconds)));
+            Clock::time_point end = Clock::now();
+
+            lock.lock();
+            transferTime += end - start;
+            if (t.lastOfFrame) framePresented.push_back(end);
+            transferDone(t.buffer);
+        }
+    }
+
+    // lv_disp_flush_ready(): the buffer may be rendered into again. Called with the lock held.
+    void transferDone(DrawBuffer* buffer) {
+        freeBuffers.push_back(buffer);
+        transferring = false;
+        bufferFree.notify_all();
+    }
+
+    DisplaySink& sink;
+    const int width;
+    const int lines;
+    const double busBytesPerSecond;
+
+    std::vector<DrawBuffer> buffers;
+    std::deque<DrawBuffer*> freeBuffers;
+    std::deque<Transfer> transfers;
+    bool transferring = false;
+    bool stop = false;
+
+    std::mutex mtx;
+    std::condition_variable bufferFree;
+    std::condition_variable transferReady;
+    std::thread worker;
+
+    bool started = false;
+    Clock::time_point firstAcquire;
+    Clock::time_point renderStart;
+    Clock::duration renderTime{0};
+    Clock::duration stallTime{0};
+    Clock::duration transferTime{0};
+    std::vector<Clock::time_point> framePresented;
+};
+
+} // namespace gfx
+
+#endif // FLUSH_PIPELINE_H
@@ -0,0 +1,388 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+// Software RGB565 framebuffer with dirty-rectangle tracking, for the GFX UI of GFX.cpp.
+//
+// GFX.cpp draws with fillRect / drawRect straight to the panel, so every redraw is pushed over SPI,
+// changed or not. Here all drawing goes into memory first, every drawing call records the area it
+// touched, and flush() sends only those areas to a DisplaySink:
+//
+//     gfx::Framebuffer fb(240, 320);
+//     fb.fillRect(30, 50, 100, 40, gfx::kBlue);      // same calls as Adafruit GFX
+//     fb.setCursor(40, 60); fb.print("Button 1");
+//     gfx::PpmSink panel(240, 320);                  // or a sink that talks to the real panel
+//     fb.flush(panel);                               // sends the dirty rectangles, then forgets them
+//     panel.save("frame.ppm");
+//
+// Dirty rectangles are merged when that does not cost more than a window-setup command would: one
+// rectangle that contains both is sent if it wastes fewer than kMergeSlackPixels pixels; otherwise the
+// overlap is cut out of the new rectangle, so the list stays disjoint and area() counts every pixel once.
+// The list never grows beyond kMaxRects; beyond that the two rectangles whose union wastes least are merged.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Font5x7.h"
+#include "PixelKernels.h"
+
+namespace gfx {
+
+// RGB565 colours with the values of the ILI9341_* constants.
+const uint16_t kBlack = 0x0000;
+const uint16_t kNavy = 0x000F;
+const uint16_t kDarkGreen = 0x03E0;
+const uint16_t kDarkGrey = 0x7BEF;
+const uint16_t kLightGrey = 0xC618;
+const uint16_t kBlue = 0x001F;
+const uint16_t kGreen = 0x07E0;
+const uint16_t kCyan = 0x07FF;
+const uint16_t kRed = 0xF800;
+const uint16_t kMagenta = 0xF81F;
+const uint16_t kYellow = 0xFFE0;
+const uint16_t kOrange = 0xFD20;
+const uint16_t kWhite = 0xFFFF;
+
+inline uint16_t rgb565(uint8_t r, uint8_t g, uint8_t b) {
+    return (uint16_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+}
+
+struct Rect {
+    int x = 0, y = 0, w = 0, h = 0;
+
+    Rect() = default;
+    Rect(int x, int y, int w, int h) : x(x), y(y), w(w), h(h) {}
+
+    bool empty() const { return w <= 0 || h <= 0; }
+    int right() const { return x + w; }    // exclusive
+    int bottom() const { return y + h; }   // exclusive
+    long area() const { return empty() ? 0 : (long)w * h; }
+
+    bool contains(int px, int py) const { return px >= x && px < right() && py >= y && py < bottom(); }
+    bool contains(const Rect& r) const {
+        return r.x >= x && r.y >= y && r.right() <= right() && r.bottom() <= bottom();
+    }
+    bool intersects(const Rect& r) const {
+        return r.x < right() && x < r.right() && r.y < bottom() && y < r.bottom();
+    }
+
+    Rect intersect(const Rect& r) const {
+        int nx = std::max(x, r.x), ny = std::max(y, r.y);
+        int nr = std::min(right(), r.right()), nb = std::min(bottom(), r.bottom());
+        if (nr <= nx || nb <= ny) return Rect();
+        return Rect(nx, ny, nr - nx, nb - ny);
+    }
+
+    Rect unite(const Rect& r) const {
+        if (empty()) return r;
+        if (r.empty()) return *this;
+        int nx = std::min(x, r.x), ny = std::min(y, r.y);
+        return Rect(nx, ny, std::max(right(), r.right()) - nx, std::max(bottom(), r.bottom()) - ny);
+    }
+
+    bool operator==(const Rect& r) const { return x == r.x && y == r.y && w == r.w && h == r.h; }
+};
+
+class DirtyRegion {
+public:
+    static const size_t kMaxRects = 16;
+    static const long kMergeSlackPixels = 64;   // roughly what the column/page address commands cost
+
+    void add(Rect r) {
+        if (r.empty()) return;
+        bool merged = true;
+        while (merged) {   // a merge can make the rectangle overlap others, so repeat until stable
+            merged = false;
+            for (size_t i = 0; i < rects.size(); ++i) {
+                const Rect& e = rects[i];
+                if (e.contains(r)) return;
+                Rect u = e.unite(r);
+                if (r.contains(e) ||
+                    u.area() <= e.area() + r.area() - e.intersect(r).area() + kMergeSlackPixels) {
+                    r = u;
+                    rects.erase(rects.begin() + i);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+        // Overlaps that were not worth merging are cut out, so no pixel is listed (and sent) twice.
+        std::vector<Rect> pieces(1, r), rest;
+        for (const Rect& e : rects) {
+            rest.clear();
+            for (const Rect& p : pieces) subtract(p, e, rest);
+            pieces.swap(rest);
+        }
+        rects.insert(rects.end(), pieces.begin(), pieces.end());
+        while (rects.size() > kMaxRects) mergeCheapestPair();
+    }
+
+    void clear() { rects.clear(); }
+    bool empty() const { return rects.empty(); }
+    const std::vector<Rect>& list() const { return rects; }
+
+    long area() const {
+        long total = 0;
+        for (const Rect& r : rects) total += r.area();
+        return total;
+    }
+
+    Rect bounds() const {
+        Rect b;
+        for (const Rect& r : rects) b = b.unite(r);
+        return b;
+    }
+
+private:
+    void mergeCheapestPair() {
+        size_t bestI = 0, bestJ = 1;
+        long bestWaste = -1;
+        for (size_t i = 0; i < rects.size(); ++i) {
+            for (size_t j = i + 1; j < rects.size(); ++j) {
+                long waste = rects[i].unite(rects[j]).area() - rects[i].area() - rects[j].area();
+                if (bestWaste < 0 || waste < bestWaste) {
+                    bestWaste = waste;
+                    bestI = i;
+                    bestJ = j;
+                }
+            }
+        }
+        Rect u = rects[bestI].unite(rects[bestJ]);
+        rects.erase(rects.begin() + bestJ);
+        rects.erase(rects.begin() + bestI);
+        // The union may cover parts of other rectangles: take those in whole, so the list shrinks.
+        for (size_t i = 0; i < rects.size();) {
+            if (rects[i].intersects(u)) {
+                u = u.unite(rects[i]);
+                rects.erase(rects.begin() + i);
+                i = 0;
+            } else {
+                ++i;
+            }
+        }
+        rects.push_back(u);
+    }
+
+    // Appends r minus e to 'out': up to four bands (above, below, left and right of the overlap).
+    static void subtract(const Rect& r, const Rect& e, std::vector<Rect>& out) {
+        Rect o = r.intersect(e);
+        if (o.empty()) {
+            out.push_back(r);
+            return;
+        }
+        if (o.y > r.y) out.push_back(Rect(r.x, r.y, r.w, o.y - r.y));
+        if (o.bottom() < r.bottom()) out.push_back(Rect(r.x, o.bottom(), r.w, r.bottom() - o.bottom()));
+        if (o.x > r.x) out.push_back(Rect(r.x, o.y, o.x - r.x, o.h));
+        if (o.right() < r.right()) out.push_back(Rect(o.right(), o.y, r.right() - o.right(), o.h));
+    }
+
+    std::vector<Rect> rects;   // disjoint: no pixel is in two of them
+};
+
+// Where flushed pixels go: the panel driver on the device, a file or a window on the host.
+class DisplaySink {
+public:
+    virtual ~DisplaySink() = default;
+    virtual void beginFrame() {}
+    // 'pixels' points at the top-left pixel of 'area'; rows are 'stride' pixels apart.
+    virtual void write(const Rect& area, const uint16_t* pixels, int stride) = 0;
+    virtual void endFrame() {}
+};
+
+struct FlushStats {
+    size_t rects = 0;
+    long pixels = 0;
+};
+
+class Framebuffer {
+public:
+    Framebuffer(int width, int height)
+        : w(width), h(height), buffer((size_t)width * height, kBlack) {
+        invalidate(bounds());   // the panel content is unknown until the first flush
+    }
+
+    int width() const { return w; }
+    int height() const { return h; }
+    Rect bounds() const { return Rect(0, 0, w, h); }
+    uint16_t* pixels() { return buffer.data(); }
+    const uint16_t* pixels() const { return buffer.data(); }
+    uint16_t pixel(int x, int y) const { return buffer[(size_t)y * w + x]; }
+
+    // Drawing, with the names and arguments of Adafruit GFX. Everything is clipped to the screen.
+    void drawPixel(int x, int y, uint16_t color) {
+        if (!bounds().contains(x, y)) return;
+        buffer[(size_t)y * w + x] = color;
+        invalidate(Rect(x, y, 1, 1));
+    }
+
+    void fillScreen(uint16_t color) { fillRect(0, 0, w, h, color); }
+
+    void fillRect(int x, int y, int rw, int rh, uint16_t color) {
+        Rect r = Rect(x, y, rw, rh).intersect(bounds());
+        if (r.empty()) return;
+        fill(r, color);
+        invalidate(r);
+    }
+
+    void drawFastHLine(int x, int y, int length, uint16_t color) { fillRect(x, y, length, 1, color); }
+    void drawFastVLine(int x, int y, int length, uint16_t color) { fillRect(x, y, 1, length, color); }
+
+    void drawRect(int x, int y, int rw, int rh, uint16_t color) {
+        drawFastHLine(x, y, rw, color);
+        drawFastHLine(x, y + rh - 1, rw, color);
+        drawFastVLine(x, y, rh, color);
+        drawFastVLine(x + rw - 1, y, rh, color);
+    }
+
+    // Text as in GFX: transparent background, 6x8 pixel cells scaled by the text size.
+    void setCursor(int x, int y) {
+        cursorX = x;
+        cursorY = y;
+    }
+    void setTextColor(uint16_t color) { textColor = color; }
+    void setTextSize(int size) { textSize = size > 0 ? size : 1; }
+
+    // Rasterises the glyph pixel by pixel (size x size blocks), like GFX; the cell is invalidated once.
+    void drawChar(int x, int y, char c, uint16_t color, int size) {
+        const uint8_t* columns = glyph(c);
+        for (int col = 0; col < kGlyphWidth; ++col) {
+            for (int row = 0; row < kGlyphHeight; ++row) {
+                if (columns[col] & (1 << row)) {
+                    fill(Rect(x + col * size, y + row * size, size, size).intersect(bounds()), color);
+                }
+            }
+        }
+        invalidate(Rect(x, y, kGlyphWidth * size, kGlyphHeight * size));
+    }
+
+    void print(const std::string& text) {
+        for (char c : text) {
+            if (c == '\n') {
+                cursorX = 0;
+                cursorY += kCellHeight * textSize;
+                continue;
+            }
+            drawChar(cursorX, cursorY, c, textColor, textSize);
+            cursorX += kCellWidth * textSize;
+        }
+    }
+
+    // Copies a w x h RGB565 image to (x, y), clipped to the screen.
+    void drawRGBBitmap(int x, int y, const uint16_t* bitmap, int bw, int bh) {
+        Rect r = Rect(x, y, bw, bh).intersect(bounds());
+        if (r.empty()) return;
+        const pixelkernels::Kernels& k = pixelkernels::pixelKernels();
+        for (int row = r.y; row < r.bottom(); ++row) {
+            k.copy16(&buffer[(size_t)row * w + r.x], bitmap + (size_t)(row - y) * bw + (r.x - x), (size_t)r.w);
+        }
+        invalidate(r);
+    }
+
+    // Blends a w x h ARGB8888 image (icons, anti-aliased text) over the screen at (x, y), clipped.
+    void blendARGBBitmap(int x, int y, const uint32_t* bitmap, int bw, int bh) {
+        Rect r = Rect(x, y, bw, bh).intersect(bounds());
+        if (r.empty()) return;
+        const pixelkernels::Kernels& k = pixelkernels::pixelKernels();
+        for (int row = r.y; row < r.bottom(); ++row) {
+            k.blendOver565(&buffer[(size_t)row * w + r.x], bitmap + (size_t)(row - y) * bw + (r.x - x), (size_t)r.w);
+        }
+        invalidate(r);
+    }
+
+    static Rect textBounds(int x, int y, const std::string& text, int size) {
+        return Rect(x, y, (int)text.size() * kCellWidth * size, kCellHeight * size);
+    }
+
+    // Marks an area as changed, e.g. after writing into pixels() directly.
+    void invalidate(const Rect& r) { dirtyRegion.add(r.intersect(bounds())); }
+
+    const DirtyRegion& dirty() const { return dirtyRegion; }
+
+    // Sends every dirty rectangle to the sink and clears the dirty list.
+    FlushStats flush(DisplaySink& sink) {
+        FlushStats stats;
+        if (dirtyRegion.empty()) return stats;
+        sink.beginFrame();
+        for (const Rect& r : dirtyRegion.list()) {
+            sink.write(r, &buffer[(size_t)r.y * w + r.x], w);
+            ++stats.rects;
+            stats.pixels += r.area();
+        }
+        sink.endFrame();
+        dirtyRegion.clear();
+        return stats;
+    }
+
+private:
+    // Fills an already clipped rectangle without recording it as dirty.
+    void fill(const Rect& r, uint16_t color) {
+        const pixelkernels::Kernels& k = pixelkernels::pixelKernels();
+        if (r.x == 0 && r.w == w) {   // whole rows are contiguous: one call
+            k.fill16(&buffer[(size_t)r.y * w], (size_t)r.w * r.h, color);
+            return;
+        }
+        for (int row = r.y; row < r.bottom(); ++row) k.fill16(&buffer[(size_t)row * w + r.x], (size_t)r.w, color);
+    }
+
+    int w, h;
+    std::vector<uint16_t> buffer;
+    DirtyRegion dirtyRegion;
+    int cursorX = 0, cursorY = 0;
+    uint16_t textColor = kWhite;
+    int textSize = 1;
+};
+
+// Host-side sink: keeps a copy of what the panel would show and writes it as a PPM image.
+// It also counts the traffic an SPI panel would see: 2 bytes per pixel plus the window-setup
+// commands (CASET + PASET + RAMWR, 11 bytes) for every rectangle.
+class PpmSink : public DisplaySink {
+public:
+    static const long kCommandBytesPerRect = 11;
+
+    PpmSink(int width, int height) : w(width), h(height), panel((size_t)width * height, kBlack) {}
+
+    void write(const Rect& area, const uint16_t* pixels, int stride) override {
+        for (int row = 0; row < area.h; ++row) {
+            std::copy(pixels + (size_t)row * stride, pixels + (size_t)row * stride + area.w,
+                      &panel[(size_t)(area.y + row) * w + area.x]);
+        }
+        bytesSent += area.area() * 2 + kCommandBytesPerRect;
+        ++writes;
+    }
+
+    void endFrame() override { ++frames; }
+
+    // Binary PPM (P6), viewable with most image viewers; RGB565 is expanded to 8 bits per channel.
+    bool save(const std::string& filename) const {
+        std::FILE* file = std::fopen(filename.c_str(), "wb");
+        if (!file) return false;
+        std::fprintf(file, "P6\n%d %d\n255\n", w, h);
+        std::vector<uint8_t> row((size_t)w * 3);
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) {
+                uint16_t c = panel[(size_t)y * w + x];
+                uint8_t r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+                row[x * 3 + 0] = (uint8_t)((r << 3) | (r >> 2));
+                row[x * 3 + 1] = (uint8_t)((g << 2) | (g >> 4));
+                row[x * 3 + 2] = (uint8_t)((b << 3) | (b >> 2));
+            }
+            std::fwrite(row.data(), 1, row.size(), file);
+        }
+        return std::fclose(file) == 0;
+    }
+
+    uint16_t pixel(int x, int y) const { return panel[(size_t)y * w + x]; }
+
+    long bytesSent = 0;
+    long writes = 0;
+    long frames = 0;
+
+private:
+    int w, h;
+    std::vector<uint16_t> panel;
+};
+
+} // namespace gfx
+
+#endif // FRAMEBUFFER_H
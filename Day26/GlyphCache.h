@@ -0,0 +1,266 @@
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+// Pre-rasterised text for the Framebuffer: a glyph atlas per text size and an LRU cache of whole labels.
+//
+// Framebuffer::print() (like GFX) walks the font's column bits for every character every time it is drawn
+// and fills one size x size block per set bit. drawButton() redraws the same labels frame after frame, so
+// almost all of that work repeats:
+//
+//     gfx::GlyphAtlas font;                         // kFont5x7, textures built per size on first use
+//     font.drawText(tft, x, y, "Button 1", gfx::kWhite, 2);         // glyph by glyph from the atlas
+//
+//     gfx::LabelCache labels(16 * 1024);            // memory budget in bytes
+//     labels.draw(tft, font, x, y, "Button 1", 2, gfx::kWhite);     // whole label from its stored runs
+//
+// GlyphAtlas: for each size one texture with every glyph's kCellWidth*size x kCellHeight*size cell, one
+// coverage byte (0 or 255) per pixel. The cells are stored one after the other, so a glyph is a single
+// contiguous block of memory (size 2: 192 bytes per glyph, 18 KB for the whole font).
+//
+// LabelCache: finished labels keyed by (text, font, size, color). The font has one colour and no
+// anti-aliasing, so a label strip is stored as its horizontal runs of stroke pixels (row, x, length) and
+// drawn with one fill per run; a 9-character label at size 1 is about 100 runs, 600 bytes. When a new label
+// would exceed the budget, the least recently drawn labels are dropped first. A label larger than the
+// whole budget is drawn but not cached.
+//
+// Both produce exactly the pixels of setCursor() + setTextColor() + setTextSize() + print() for one line of
+// text (no '\n'), including the transparent background. Neither class is thread-safe, like Framebuffer.
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Font5x7.h"
+#include "Framebuffer.h"
+
+namespace gfx {
+
+typedef uint8_t FontColumns[kGlyphWidth];
+
+class GlyphAtlas {
+public:
+    explicit GlyphAtlas(const FontColumns* font = kFont5x7) : columns(font) {}
+
+    const FontColumns* font() const { return columns; }
+
+    // Coverage of the cell of 'c' at text size 'size': cellWidth(size) x cellHeight(size) bytes, row by row.
+    const uint8_t* cell(char c, int size) {
+        if (c < kFirstGlyph || c > kLastGlyph) c = '?';
+        const std::vector<uint8_t>& t = texture(size);
+        return &t[(size_t)(c - kFirstGlyph) * cellWidth(size) * cellHeight(size)];
+    }
+
+    static int cellWidth(int size) { return kCellWidth * size; }
+    static int cellHeight(int size) { return kCellHeight * size; }
+
+    // Memory used by all textures built so far.
+    size_t bytes() const {
+        size_t total = 0;
+        for (const std::vector<uint8_t>& t : textures) total += t.size();
+        return total;
+    }
+
+    // Same pixels as print(text) at (x, y), copied from the atlas; clipped to the screen.
+    void drawText(Framebuffer& fb, int x, int y, const std::string& text, uint16_t color, int size) {
+        int cw = cellWidth(size), ch = cellHeight(size);
+        Rect textRect = Rect(x, y, (int)text.size() * cw, ch).intersect(fb.bounds());
+        if (textRect.empty()) return;
+        uint16_t* pixels = fb.pixels();
+        for (size_t i = 0; i < text.size(); ++i, x += cw) {
+            Rect r = Rect(x, y, cw, ch).intersect(textRect);
+            if (r.empty()) continue;
+            const uint8_t* coverage = cell(text[i], size);
+            for (int row = r.y; row < r.bottom(); ++row) {
+                const uint8_t* src = coverage + (size_t)(row - y) * cw;
+                uint16_t* dst = pixels + (size_t)row * fb.width();
+                for (int col = r.x; col < r.right(); ++col) {
+                    if (src[col - x]) dst[col] = color;
+                }
+            }
+        }
+        fb.invalidate(textRect);
+    }
+
+private:
+    const std::vector<uint8_t>& texture(int size) {
+        if (size < 1) size = 1;
+        if ((size_t)size > textures.size()) textures.resize(size);
+        std::vector<uint8_t>& t = textures[size - 1];
+        if (t.empty()) build(t, size);
+        return t;
+    }
+
+    // Rasterises every glyph once, the way drawChar does: bit 'row' of a column byte becomes a size x size block.
+    void build(std::vector<uint8_t>& t, int size) {
+        int cw = cellWidth(size), ch = cellHeight(size);
+        size_t glyphs = kLastGlyph - kFirstGlyph + 1;
+        t.assign(glyphs * cw * ch, 0);
+        for (size_t g = 0; g < glyphs; ++g) {
+            uint8_t* cellPixels = &t[g * cw * ch];
+            for (int col = 0; col < kGlyphWidth; ++col) {
+                for (int row = 0; row < kGlyphHeight; ++row) {
+                    if (!(columns[g][col] & (1 << row))) continue;
+                    for (int py = row * size; py < (row + 1) * size; ++py) {
+                        for (int px = col * size; px < (col + 1) * size; ++px) cellPixels[py * cw + px] = 255;
+                    }
+                }
+            }
+        }
+    }
+
+    const FontColumns* columns;
+    std::vector<std::vector<uint8_t>> textures;   // [size - 1]
+};
+
+class LabelCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t uncached = 0;   // labels larger than the whole budget
+        size_t labels = 0;
+        size_t bytes = 0;
+    };
+
+    explicit LabelCache(size_t budgetBytes = 16 * 1024) : budget(budgetBytes) {}
+
+    LabelCache(const LabelCache&) = delete;
+    LabelCache& operator=(const LabelCache&) = delete;
+
+    // Draws 'text' like print() would, rendering the label strip only if it is not cached yet.
+    void draw(Framebuffer& fb, GlyphAtlas& atlas, int x, int y, const std::string& text, int size, uint16_t color) {
+        if (size < 1) size = 1;
+        Key key{text, atlas.font(), size, color};
+        auto found = index.find(key);
+        if (found != index.end()) {
+            ++counters.hits;
+            entries.splice(entries.begin(), entries, found->second);   // now the most recently used
+            paint(fb, x, y, *found->second);
+            return;
+        }
+
+        ++counters.misses;
+        Label label{key, GlyphAtlas::cellWidth(size) * (int)text.size(), GlyphAtlas::cellHeight(size), {}};
+        render(label, atlas);
+        paint(fb, x, y, label);
+        size_t cost = bytesOf(label);
+        if (cost > budget) {
+            ++counters.uncached;
+            return;
+        }
+        while (used + cost > budget) evictOldest();
+        entries.push_front(std::move(label));
+        index.emplace(entries.front().key, entries.begin());
+        used += cost;
+    }
+
+    void clear() {
+        entries.clear();
+        index.clear();
+        used = 0;
+    }
+
+    size_t budgetBytes() const { return budget; }
+
+    Stats stats() const {
+        Stats s = counters;
+        s.labels = entries.size();
+        s.bytes = used;
+        return s;
+    }
+
+private:
+    struct Key {
+        std::string text;
+        const FontColumns* font;
+        int size;
+        uint16_t color;
+
+        bool operator==(const Key& o) const {
+            return size == o.size && color == o.color && font == o.font && text == o.text;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& k) const {
+            size_t h = std::hash<std::string>()(k.text);
+            h ^= std::hash<const void*>()(k.font) + 0x9E3779B9u + (h << 6) + (h >> 2);
+            h ^= ((size_t)k.size << 16 | k.color) + 0x9E3779B9u + (h << 6) + (h >> 2);
+            return h;
+        }
+    };
+
+    // A horizontal run of stroke pixels; everything between the runs is transparent.
+    struct Span {
+        uint16_t row, x, length;
+    };
+
+    struct Label {
+        Key key;
+        int width, height;
+        std::vector<Span> spans;   // row by row, left to right
+    };
+
+    // What a label counts against the budget: its runs, its text and its bookkeeping.
+    static size_t bytesOf(const Label& label) {
+        return label.spans.size() * sizeof(Span) + label.key.text.size() + sizeof(Label);
+    }
+
+    // Turns the atlas cells of the text into runs. Runs continue across cell borders, so a label usually
+    // needs fewer runs than its glyphs would separately.
+    static void render(Label& label, GlyphAtlas& atlas) {
+        int size = label.key.size;
+        int cw = GlyphAtlas::cellWidth(size);
+        const std::string& text = label.key.text;
+        std::vector<const uint8_t*> cells(text.size());
+        for (size_t i = 0; i < text.size(); ++i) cells[i] = atlas.cell(text[i], size);
+        for (int row = 0; row < label.height; ++row) {
+            int runStart = -1;
+            for (int x = 0; x <= label.width; ++x) {
+                bool set = x < label.width && cells[x / cw][row * cw + x % cw];
+                if (set && runStart < 0) runStart = x;
+                if (!set && runStart >= 0) {
+                    label.spans.push_back(Span{(uint16_t)row, (uint16_t)runStart, (uint16_t)(x - runStart)});
+                    runStart = -1;
+                }
+            }
+        }
+        label.spans.shrink_to_fit();
+    }
+
+    static void paint(Framebuffer& fb, int x, int y, const Label& label) {
+        Rect clip = Rect(x, y, label.width, label.height).intersect(fb.bounds());
+        if (clip.empty()) return;
+        uint16_t* pixels = fb.pixels();
+        uint16_t color = label.key.color;
+        for (const Span& s : label.spans) {
+            int py = y + s.row;
+            if (py < clip.y || py >= clip.bottom()) continue;
+            int from = std::max(x + s.x, clip.x), to = std::min(x + s.x + s.length, clip.right());
+            if (from < to) std::fill(pixels + (size_t)py * fb.width() + from, pixels + (size_t)py * fb.width() + to, color);
+        }
+        fb.invalidate(clip);
+    }
+
+    void evictOldest() {
+        Label& oldest = entries.back();
+        used -= bytesOf(oldest);
+        index.erase(oldest.key);
+        entries.pop_back();
+        ++counters.evictions;
+    }
+
+    size_t budget;
+    size_t used = 0;
+    std::list<Label> entries;   // most recently drawn first
+    std::unordered_map<Key, std::list<Label>::iterator, KeyHash> index;
+    Stats counters;
+};
+
+} // namespace gfx
+
+#endif // GLYPH_CACHE_H
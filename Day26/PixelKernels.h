@@ -0,0 +1,456 @@
+#ifndef PIXEL_KERNELS_H
+#define PIXEL_KERNELS_H
+
+// Row kernels for RGB565 and ARGB8888 pixels: solid fill, copy (blit), alpha blend and colour conversion.
+//
+// Every kernel exists as a plain scalar loop (the reference) and as SIMD versions:
+//     SSE2  8 RGB565 / 4 ARGB pixels per instruction   (every x86-64 CPU)
+//     AVX2  16 / 8 pixels                               (chosen at runtime, like ShapeBatch.h does with AVX)
+//     NEON  8 / 4 pixels, blend 8 at a time             (ARM, compile time: every AArch64 CPU has it)
+// pixelKernels() returns the best table for this CPU; availableKernels() returns all of them so the
+// results can be compared (challeng26_2.cpp checks that every version gives the same bits as the scalar one).
+//
+// Pixel formats: RGB565 = rrrrrggg gggbbbbb; ARGB8888 = 0xAARRGGBB in a uint32_t.
+// Blending (ARGB source over RGB565 destination) works on the 5/6/5-bit channels:
+//     out = round((src * a + dst * (255 - a)) / 255)
+// with an exact integer division by 255, so the SIMD versions are bit-identical to the scalar one.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PIXEL_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON)
+#define PIXEL_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace pixelkernels {
+
+struct Kernels {
+    const char* name;
+    void (*fill16)(uint16_t* dst, size_t n, uint16_t color);
+    void (*fill32)(uint32_t* dst, size_t n, uint32_t color);
+    void (*copy16)(uint16_t* dst, const uint16_t* src, size_t n);
+    void (*copy32)(uint32_t* dst, const uint32_t* src, size_t n);
+    void (*blendOver565)(uint16_t* dst, const uint32_t* src, size_t n);
+    void (*rgb565ToArgb8888)(uint32_t* dst, const uint16_t* src, size_t n);
+    void (*argb8888ToRgb565)(uint16_t* dst, const uint32_t* src, size_t n);
+};
+
+// ---- Scalar reference ----
+
+inline uint32_t div255(uint32_t t) {   // round(t / 255) for t <= 65025
+    t += 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+inline void fill16Scalar(uint16_t* dst, size_t n, uint16_t color) {
+    for (size_t i = 0; i < n; ++i) dst[i] = color;
+}
+
+inline void fill32Scalar(uint32_t* dst, size_t n, uint32_t color) {
+    for (size_t i = 0; i < n; ++i) dst[i] = color;
+}
+
+inline void copy16Scalar(uint16_t* dst, const uint16_t* src, size_t n) {
+    for (size_t i = 0; i < n; ++i) dst[i] = src[i];
+}
+
+inline void copy32Scalar(uint32_t* dst, const uint32_t* src, size_t n) {
+    for (size_t i = 0; i < n; ++i) dst[i] = src[i];
+}
+
+inline void blendOver565Scalar(uint16_t* dst, const uint32_t* src, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t s = src[i], d = dst[i];
+        uint32_t a = s >> 24, inv = 255 - a;
+        uint32_t r = div255(((s >> 19) & 0x1F) * a + (d >> 11) * inv);
+        uint32_t g = div255(((s >> 10) & 0x3F) * a + ((d >> 5) & 0x3F) * inv);
+        uint32_t b = div255(((s >> 3) & 0x1F) * a + (d & 0x1F) * inv);
+        dst[i] = (uint16_t)((r << 11) | (g << 5) | b);
+    }
+}
+
+inline void rgb565ToArgb8888Scalar(uint32_t* dst, const uint16_t* src, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t c = src[i];
+        uint32_t r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+        dst[i] = 0xFF000000u | (((r << 3) | (r >> 2)) << 16) | (((g << 2) | (g >> 4)) << 8) | ((b << 3) | (b >> 2));
+    }
+}
+
+inline void argb8888ToRgb565Scalar(uint16_t* dst, const uint32_t* src, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t c = src[i];
+        dst[i] = (uint16_t)(((c >> 8) & 0xF800) | ((c >> 5) & 0x07E0) | ((c >> 3) & 0x001F));
+    }
+}
+
+inline const Kernels& scalarKernels() {
+    static const Kernels k = {"scalar", fill16Scalar, fill32Scalar, copy16Scalar, copy32Scalar,
+                              blendOver565Scalar, rgb565ToArgb8888Scalar, argb8888ToRgb565Scalar};
+    return k;
+}
+
+#ifdef PIXEL_KERNELS_X86
+
+// ---- SSE2 ----
+
+inline void fill16Sse2(uint16_t* dst, size_t n, uint16_t color) {
+    const __m128i v = _mm_set1_epi16((short)color);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) _mm_storeu_si128((__m128i*)(dst + i), v);
+    fill16Scalar(dst + i, n - i, color);
+}
+
+inline void fill32Sse2(uint32_t* dst, size_t n, uint32_t color) {
+    const __m128i v = _mm_set1_epi32((int)color);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) _mm_storeu_si128((__m128i*)(dst + i), v);
+    fill32Scalar(dst + i, n - i, color);
+}
+
+inline void copyBytesSse2(uint8_t* dst, const uint8_t* src, size_t bytes) {
+    size_t i = 0;
+    for (; i + 32 <= bytes; i += 32) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + i + 16));
+        _mm_storeu_si128((__m128i*)(dst + i), a);
+        _mm_storeu_si128((__m128i*)(dst + i + 16), b);
+    }
+    std::memcpy(dst + i, src + i, bytes - i);
+}
+
+inline void copy16Sse2(uint16_t* dst, const uint16_t* src, size_t n) { copyBytesSse2((uint8_t*)dst, (const uint8_t*)src, n * 2); }
+inline void copy32Sse2(uint32_t* dst, const uint32_t* src, size_t n) { copyBytesSse2((uint8_t*)dst, (const uint8_t*)src, n * 4); }
+
+// 32-bit lanes -> 16-bit lanes, for values up to 0xFFFF (SSE2 only has a signed saturating pack).
+inline __m128i packU32ToU16Sse2(__m128i lo, __m128i hi) {
+    const __m128i bias32 = _mm_set1_epi32(0x8000);
+    const __m128i bias16 = _mm_set1_epi16((short)0x8000);
+    return _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(lo, bias32), _mm_sub_epi32(hi, bias32)), bias16);
+}
+
+inline __m128i div255Sse2(__m128i t) {   // 16-bit lanes, t <= 16065
+    t = _mm_add_epi16(t, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+inline void blendOver565Sse2(uint16_t* dst, const uint32_t* src, size_t n) {
+    const __m128i mask5 = _mm_set1_epi16(0x1F), mask6 = _mm_set1_epi16(0x3F), c255 = _mm_set1_epi16(255);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i s0 = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i s1 = _mm_loadu_si128((const __m128i*)(src + i + 4));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        // Every value below fits in 15 bits, so the signed pack is safe.
+        __m128i a = _mm_packs_epi32(_mm_srli_epi32(s0, 24), _mm_srli_epi32(s1, 24));
+        __m128i sr = _mm_and_si128(_mm_packs_epi32(_mm_srli_epi32(s0, 19), _mm_srli_epi32(s1, 19)), mask5);
+        __m128i sg = _mm_and_si128(_mm_packs_epi32(_mm_srli_epi32(_mm_slli_epi32(s0, 8), 18),
+                                                   _mm_srli_epi32(_mm_slli_epi32(s1, 8), 18)), mask6);
+        __m128i sb = _mm_and_si128(_mm_packs_epi32(_mm_srli_epi32(_mm_slli_epi32(s0, 16), 19),
+                                                   _mm_srli_epi32(_mm_slli_epi32(s1, 16), 19)), mask5);
+        __m128i inv = _mm_sub_epi16(c255, a);
+        __m128i r = div255Sse2(_mm_add_epi16(_mm_mullo_epi16(sr, a), _mm_mullo_epi16(_mm_srli_epi16(d, 11), inv)));
+        __m128i g = div255Sse2(_mm_add_epi16(_mm_mullo_epi16(sg, a),
+                                             _mm_mullo_epi16(_mm_and_si128(_mm_srli_epi16(d, 5), mask6), inv)));
+        __m128i b = div255Sse2(_mm_add_epi16(_mm_mullo_epi16(sb, a), _mm_mullo_epi16(_mm_and_si128(d, mask5), inv)));
+        __m128i out = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(r, 11), _mm_slli_epi16(g, 5)), b);
+        _mm_storeu_si128((__m128i*)(dst + i), out);
+    }
+    blendOver565Scalar(dst + i, src + i, n - i);
+}
+
+inline __m128i expand565Sse2(__m128i c) {   // 32-bit lanes holding RGB565 -> 0xFFRRGGBB
+    __m128i r = _mm_and_si128(_mm_srli_epi32(c, 11), _mm_set1_epi32(0x1F));
+    __m128i g = _mm_and_si128(_mm_srli_epi32(c, 5), _mm_set1_epi32(0x3F));
+    __m128i b = _mm_and_si128(c, _mm_set1_epi32(0x1F));
+    r = _mm_or_si128(_mm_slli_epi32(r, 3), _mm_srli_epi32(r, 2));
+    g = _mm_or_si128(_mm_slli_epi32(g, 2), _mm_srli_epi32(g, 4));
+    b = _mm_or_si128(_mm_slli_epi32(b, 3), _mm_srli_epi32(b, 2));
+    return _mm_or_si128(_mm_or_si128(_mm_set1_epi32((int)0xFF000000u), _mm_slli_epi32(r, 16)),
+                        _mm_or_si128(_mm_slli_epi32(g, 8), b));
+}
+
+inline void rgb565ToArgb8888Sse2(uint32_t* dst, const uint16_t* src, size_t n) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i c = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dst + i), expand565Sse2(_mm_unpacklo_epi16(c, zero)));
+        _mm_storeu_si128((__m128i*)(dst + i + 4), expand565Sse2(_mm_unpackhi_epi16(c, zero)));
+    }
+    rgb565ToArgb8888Scalar(dst + i, src + i, n - i);
+}
+
+inline __m128i reduce8888Sse2(__m128i c) {   // 0xAARRGGBB -> RGB565 in 32-bit lanes
+    return _mm_or_si128(_mm_or_si128(_mm_and_si128(_mm_srli_epi32(c, 8), _mm_set1_epi32(0xF800)),
+                                     _mm_and_si128(_mm_srli_epi32(c, 5), _mm_set1_epi32(0x07E0))),
+                        _mm_and_si128(_mm_srli_epi32(c, 3), _mm_set1_epi32(0x001F)));
+}
+
+inline void argb8888ToRgb565Sse2(uint16_t* dst, const uint32_t* src, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i lo = reduce8888Sse2(_mm_loadu_si128((const __m128i*)(src + i)));
+        __m128i hi = reduce8888Sse2(_mm_loadu_si128((const __m128i*)(src + i + 4)));
+        _mm_storeu_si128((__m128i*)(dst + i), packU32ToU16Sse2(lo, hi));
+    }
+    argb8888ToRgb565Scalar(dst + i, src + i, n - i);
+}
+
+inline const Kernels& sse2Kernels() {
+    static const Kernels k = {"sse2", fill16Sse2, fill32Sse2, copy16Sse2, copy32Sse2,
+                              blendOver565Sse2, rgb565ToArgb8888Sse2, argb8888ToRgb565Sse2};
+    return k;
+}
+
+// ---- AVX2 ----
+// _mm256_packs_epi32 packs within each 128-bit half; the permute puts the 16 results back in order.
+
+#define PIXEL_KERNELS_AVX2 __attribute__((target("avx2")))
+
+PIXEL_KERNELS_AVX2 inline void fill16Avx2(uint16_t* dst, size_t n, uint16_t color) {
+    const __m256i v = _mm256_set1_epi16((short)color);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) _mm256_storeu_si256((__m256i*)(dst + i), v);
+    fill16Scalar(dst + i, n - i, color);
+}
+
+PIXEL_KERNELS_AVX2 inline void fill32Avx2(uint32_t* dst, size_t n, uint32_t color) {
+    const __m256i v = _mm256_set1_epi32((int)color);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) _mm256_storeu_si256((__m256i*)(dst + i), v);
+    fill32Scalar(dst + i, n - i, color);
+}
+
+PIXEL_KERNELS_AVX2 inline void copyBytesAvx2(uint8_t* dst, const uint8_t* src, size_t bytes) {
+    size_t i = 0;
+    for (; i + 64 <= bytes; i += 64) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src + i + 32));
+        _mm256_storeu_si256((__m256i*)(dst + i), a);
+        _mm256_storeu_si256((__m256i*)(dst + i + 32), b);
+    }
+    std::memcpy(dst + i, src + i, bytes - i);
+}
+
+PIXEL_KERNELS_AVX2 inline void copy16Avx2(uint16_t* dst, const uint16_t* src, size_t n) {
+    copyBytesAvx2((uint8_t*)dst, (const uint8_t*)src, n * 2);
+}
+PIXEL_KERNELS_AVX2 inline void copy32Avx2(uint32_t* dst, const uint32_t* src, size_t n) {
+    copyBytesAvx2((uint8_t*)dst, (const uint8_t*)src, n * 4);
+}
+
+PIXEL_KERNELS_AVX2 inline __m256i pack32To16Avx2(__m256i lo, __m256i hi) {   // values < 0x8000
+    return _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+}
+
+PIXEL_KERNELS_AVX2 inline __m256i div255Avx2(__m256i t) {
+    t = _mm256_add_epi16(t, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+PIXEL_KERNELS_AVX2 inline void blendOver565Avx2(uint16_t* dst, const uint32_t* src, size_t n) {
+    const __m256i mask5 = _mm256_set1_epi16(0x1F), mask6 = _mm256_set1_epi16(0x3F), c255 = _mm256_set1_epi16(255);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i s0 = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i s1 = _mm256_loadu_si256((const __m256i*)(src + i + 8));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i a = pack32To16Avx2(_mm256_srli_epi32(s0, 24), _mm256_srli_epi32(s1, 24));
+        __m256i sr = _mm256_and_si256(pack32To16Avx2(_mm256_srli_epi32(s0, 19), _mm256_srli_epi32(s1, 19)), mask5);
+        __m256i sg = _mm256_and_si256(pack32To16Avx2(_mm256_srli_epi32(_mm256_slli_epi32(s0, 8), 18),
+                                                     _mm256_srli_epi32(_mm256_slli_epi32(s1, 8), 18)), mask6);
+        __m256i sb = _mm256_and_si256(pack32To16Avx2(_mm256_srli_epi32(_mm256_slli_epi32(s0, 16), 19),
+                                                     _mm256_srli_epi32(_mm256_slli_epi32(s1, 16), 19)), mask5);
+        __m256i inv = _mm256_sub_epi16(c255, a);
+        __m256i r = div255Avx2(_mm256_add_epi16(_mm256_mullo_epi16(sr, a),
+                                                _mm256_mullo_epi16(_mm256_srli_epi16(d, 11), inv)));
+        __m256i g = div255Avx2(_mm256_add_epi16(_mm256_mullo_epi16(sg, a),
+                                                _mm256_mullo_epi16(_mm256_and_si256(_mm256_srli_epi16(d, 5), mask6), inv)));
+        __m256i b = div255Avx2(_mm256_add_epi16(_mm256_mullo_epi16(sb, a),
+                                                _mm256_mullo_epi16(_mm256_and_si256(d, mask5), inv)));
+        __m256i out = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi16(r, 11), _mm256_slli_epi16(g, 5)), b);
+        _mm256_storeu_si256((__m256i*)(dst + i), out);
+    }
+    blendOver565Scalar(dst + i, src + i, n - i);
+}
+
+PIXEL_KERNELS_AVX2 inline __m256i expand565Avx2(__m256i c) {
+    __m256i r = _mm256_and_si256(_mm256_srli_epi32(c, 11), _mm256_set1_epi32(0x1F));
+    __m256i g = _mm256_and_si256(_mm256_srli_epi32(c, 5), _mm256_set1_epi32(0x3F));
+    __m256i b = _mm256_and_si256(c, _mm256_set1_epi32(0x1F));
+    r = _mm256_or_si256(_mm256_slli_epi32(r, 3), _mm256_srli_epi32(r, 2));
+    g = _mm256_or_si256(_mm256_slli_epi32(g, 2), _mm256_srli_epi32(g, 4));
+    b = _mm256_or_si256(_mm256_slli_epi32(b, 3), _mm256_srli_epi32(b, 2));
+    return _mm256_or_si256(_mm256_or_si256(_mm256_set1_epi32((int)0xFF000000u), _mm256_slli_epi32(r, 16)),
+                           _mm256_or_si256(_mm256_slli_epi32(g, 8), b));
+}
+
+PIXEL_KERNELS_AVX2 inline void rgb565ToArgb8888Avx2(uint32_t* dst, const uint16_t* src, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i lo = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(src + i)));
+        __m256i hi = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(src + i + 8)));
+        _mm256_storeu_si256((__m256i*)(dst + i), expand565Avx2(lo));
+        _mm256_storeu_si256((__m256i*)(dst + i + 8), expand565Avx2(hi));
+    }
+    rgb565ToArgb8888Scalar(dst + i, src + i, n - i);
+}
+
+PIXEL_KERNELS_AVX2 inline __m256i reduce8888Avx2(__m256i c) {
+    return _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(c, 8), _mm256_set1_epi32(0xF800)),
+                                           _mm256_and_si256(_mm256_srli_epi32(c, 5), _mm256_set1_epi32(0x07E0))),
+                           _mm256_and_si256(_mm256_srli_epi32(c, 3), _mm256_set1_epi32(0x001F)));
+}
+
+PIXEL_KERNELS_AVX2 inline void argb8888ToRgb565Avx2(uint16_t* dst, const uint32_t* src, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i lo = reduce8888Avx2(_mm256_loadu_si256((const __m256i*)(src + i)));
+        __m256i hi = reduce8888Avx2(_mm256_loadu_si256((const __m256i*)(src + i + 8)));
+        // AVX2 has an unsigned pack (packus_epi32), so no bias is needed here.
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8));
+    }
+    argb8888ToRgb565Scalar(dst + i, src + i, n - i);
+}
+
+inline const Kernels& avx2Kernels() {
+    static const Kernels k = {"avx2", fill16Avx2, fill32Avx2, copy16Avx2, copy32Avx2,
+                              blendOver565Avx2, rgb565ToArgb8888Avx2, argb8888ToRgb565Avx2};
+    return k;
+}
+
+inline bool hasAvx2() {
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+
+#endif // PIXEL_KERNELS_X86
+
+#ifdef PIXEL_KERNELS_NEON
+
+// ---- NEON ----
+
+inline void fill16Neon(uint16_t* dst, size_t n, uint16_t color) {
+    const uint16x8_t v = vdupq_n_u16(color);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) vst1q_u16(dst + i, v);
+    fill16Scalar(dst + i, n - i, color);
+}
+
+inline void fill32Neon(uint32_t* dst, size_t n, uint32_t color) {
+    const uint32x4_t v = vdupq_n_u32(color);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) vst1q_u32(dst + i, v);
+    fill32Scalar(dst + i, n - i, color);
+}
+
+inline void copyBytesNeon(uint8_t* dst, const uint8_t* src, size_t bytes) {
+    size_t i = 0;
+    for (; i + 32 <= bytes; i += 32) {
+        uint8x16_t a = vld1q_u8(src + i);
+        uint8x16_t b = vld1q_u8(src + i + 16);
+        vst1q_u8(dst + i, a);
+        vst1q_u8(dst + i + 16, b);
+    }
+    std::memcpy(dst + i, src + i, bytes - i);
+}
+
+inline void copy16Neon(uint16_t* dst, const uint16_t* src, size_t n) { copyBytesNeon((uint8_t*)dst, (const uint8_t*)src, n * 2); }
+inline void copy32Neon(uint32_t* dst, const uint32_t* src, size_t n) { copyBytesNeon((uint8_t*)dst, (const uint8_t*)src, n * 4); }
+
+inline uint16x8_t div255Neon(uint16x8_t t) {
+    t = vaddq_u16(t, vdupq_n_u16(128));
+    return vshrq_n_u16(vaddq_u16(t, vshrq_n_u16(t, 8)), 8);
+}
+
+// 8 pixels; channels come from vld4_u8 (bytes of 0xAARRGGBB in memory: B, G, R, A).
+inline uint16x8_t blend8Neon(uint8x8x4_t s, uint16x8_t d) {
+    const uint16x8_t mask5 = vdupq_n_u16(0x1F), mask6 = vdupq_n_u16(0x3F);
+    uint16x8_t a = vmovl_u8(s.val[3]);
+    uint16x8_t inv = vsubq_u16(vdupq_n_u16(255), a);
+    uint16x8_t sr = vmovl_u8(vshr_n_u8(s.val[2], 3));
+    uint16x8_t sg = vmovl_u8(vshr_n_u8(s.val[1], 2));
+    uint16x8_t sb = vmovl_u8(vshr_n_u8(s.val[0], 3));
+    uint16x8_t r = div255Neon(vmlaq_u16(vmulq_u16(sr, a), vshrq_n_u16(d, 11), inv));
+    uint16x8_t g = div255Neon(vmlaq_u16(vmulq_u16(sg, a), vandq_u16(vshrq_n_u16(d, 5), mask6), inv));
+    uint16x8_t b = div255Neon(vmlaq_u16(vmulq_u16(sb, a), vandq_u16(d, mask5), inv));
+    return vorrq_u16(vorrq_u16(vshlq_n_u16(r, 11), vshlq_n_u16(g, 5)), b);
+}
+
+inline void blendOver565Neon(uint16_t* dst, const uint32_t* src, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint8x8x4_t s = vld4_u8((const uint8_t*)(src + i));
+        vst1q_u16(dst + i, blend8Neon(s, vld1q_u16(dst + i)));
+    }
+    blendOver565Scalar(dst + i, src + i, n - i);
+}
+
+inline void rgb565ToArgb8888Neon(uint32_t* dst, const uint16_t* src, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint16x8_t c = vld1q_u16(src + i);
+        uint8x8_t r = vmovn_u16(vshrq_n_u16(c, 11));
+        uint8x8_t g = vmovn_u16(vandq_u16(vshrq_n_u16(c, 5), vdupq_n_u16(0x3F)));
+        uint8x8_t b = vmovn_u16(vandq_u16(c, vdupq_n_u16(0x1F)));
+        uint8x8x4_t out;
+        out.val[0] = vorr_u8(vshl_n_u8(b, 3), vshr_n_u8(b, 2));
+        out.val[1] = vorr_u8(vshl_n_u8(g, 2), vshr_n_u8(g, 4));
+        out.val[2] = vorr_u8(vshl_n_u8(r, 3), vshr_n_u8(r, 2));
+        out.val[3] = vdup_n_u8(0xFF);
+        vst4_u8((uint8_t*)(dst + i), out);
+    }
+    rgb565ToArgb8888Scalar(dst + i, src + i, n - i);
+}
+
+inline void argb8888ToRgb565Neon(uint16_t* dst, const uint32_t* src, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint8x8x4_t s = vld4_u8((const uint8_t*)(src + i));
+        uint16x8_t r = vshlq_n_u16(vmovl_u8(vshr_n_u8(s.val[2], 3)), 11);
+        uint16x8_t g = vshlq_n_u16(vmovl_u8(vshr_n_u8(s.val[1], 2)), 5);
+        uint16x8_t b = vmovl_u8(vshr_n_u8(s.val[0], 3));
+        vst1q_u16(dst + i, vorrq_u16(vorrq_u16(r, g), b));
+    }
+    argb8888ToRgb565Scalar(dst + i, src + i, n - i);
+}
+
+inline const Kernels& neonKernels() {
+    static const Kernels k = {"neon", fill16Neon, fill32Neon, copy16Neon, copy32Neon,
+                              blendOver565Neon, rgb565ToArgb8888Neon, argb8888ToRgb565Neon};
+    return k;
+}
+
+#endif // PIXEL_KERNELS_NEON
+
+// Every version this CPU can run, the scalar reference first.
+inline std::vector<const Kernels*> availableKernels() {
+    std::vector<const Kernels*> all = {&scalarKernels()};
+#ifdef PIXEL_KERNELS_X86
+    all.push_back(&sse2Kernels());
+    if (hasAvx2()) all.push_back(&avx2Kernels());
+#endif
+#ifdef PIXEL_KERNELS_NEON
+    all.push_back(&neonKernels());
+#endif
+    return all;
+}
+
+// The fastest version for this CPU, chosen once.
+inline const Kernels& pixelKernels() {
+    static const Kernels* best = availableKernels().back();
+    return *best;
+}
+
+} // namespace pixelkernels
+
+#endif // PIXEL_KERNELS_H
@@ -0,0 +1,273 @@
+#ifndef WIDGET_INDEX_H
+#define WIDGET_INDEX_H
+
+// Registry of on-screen widgets with a uniform-grid spatial index, for touch hit-testing and partial redraws.
+//
+// GFX.cpp's drawButton() draws a button and forgets it, so loop() has no way to find out what a touch hit
+// except scanning its own list of rectangles. Widgets registered here are found through the grid:
+//
+//     gfx::WidgetIndex widgets(tft);                    // grid over the framebuffer, 32x32 pixel cells
+//     gfx::WidgetIndex::Id ok = widgets.add(gfx::Rect(30, 50, 100, 40));
+//     gfx::WidgetIndex::Id hit = widgets.hitTest(touchX, touchY);   // topmost widget there, or kNone
+//     widgets.move(popup, newBounds);                  // only the grid cells that change are touched
+//
+// Each grid cell lists the widgets overlapping it. A point query looks at one cell, a rectangle query at the
+// cells it covers, so the cost depends on how crowded that part of the screen is, not on the number of
+// widgets (hundreds of tiles on a dashboard cost the same as ten).
+//
+// Z-order: a widget with a higher z is in front; within the same z, the one added or raised last. hitTest()
+// returns the frontmost visible widget; query() lists widgets back to front, the order to draw them in.
+//
+// The index also drives the dirty rectangles of the framebuffer: add, remove, move, raise, show/hide and
+// invalidate(id) mark the affected screen area dirty, and damaged() says which widgets must be redrawn for
+// the current dirty region. Widgets are assumed to paint their whole bounds (opaque background).
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "Framebuffer.h"
+
+namespace gfx {
+
+class WidgetIndex {
+public:
+    typedef uint32_t Id;
+    static const Id kNone = 0;
+
+    explicit WidgetIndex(Framebuffer& fb, int cellSize = 32)
+        : fb(fb),
+          cellSize(cellSize),
+          columns((fb.width() + cellSize - 1) / cellSize),
+          rows((fb.height() + cellSize - 1) / cellSize),
+          cells((size_t)columns * rows) {}
+
+    WidgetIndex(const WidgetIndex&) = delete;
+    WidgetIndex& operator=(const WidgetIndex&) = delete;
+
+    Id add(const Rect& bounds, int z = 0) {
+        widgets.push_back(Widget{bounds, z, nextOrder++, true, true, 0});
+        Id id = (Id)widgets.size();
+        insert(id, bounds);
+        ++live;
+        fb.invalidate(bounds);
+        return id;
+    }
+
+    // Ids are not reused, so a stale id simply refers to nothing: the calls below ignore it, and the
+    // accessors return an empty, invisible widget at z 0.
+    void remove(Id id) {
+        Widget* w = find(id);
+        if (!w) return;
+        erase(id, w->bounds);
+        fb.invalidate(w->bounds);
+        w->alive = false;
+        --live;
+    }
+
+    // Moves or resizes a widget; the old and the new area become dirty.
+    void move(Id id, const Rect& bounds) {
+        Widget* w = find(id);
+        if (!w) return;
+        Rect old = w->bounds;
+        CellRange from = cellRange(old), to = cellRange(bounds);
+        for (int cy = from.y0; cy < from.y1; ++cy) {
+            for (int cx = from.x0; cx < from.x1; ++cx) {
+                if (!to.contains(cx, cy)) eraseFromCell(cell(cx, cy), id);
+            }
+        }
+        for (int cy = to.y0; cy < to.y1; ++cy) {
+            for (int cx = to.x0; cx < to.x1; ++cx) {
+                if (!from.contains(cx, cy)) cell(cx, cy).push_back(id);
+            }
+        }
+        w->bounds = bounds;
+        if (w->visible) {
+            fb.invalidate(old);
+            fb.invalidate(bounds);
+        }
+    }
+
+    void setZ(Id id, int z) {
+        Widget* w = find(id);
+        if (!w || w->z == z) return;
+        w->z = z;
+        if (w->visible) fb.invalidate(w->bounds);
+    }
+
+    // Brings the widget in front of all others with the same z.
+    void raise(Id id) {
+        Widget* w = find(id);
+        if (!w) return;
+        w->order = nextOrder++;
+        if (w->visible) fb.invalidate(w->bounds);
+    }
+
+    void setVisible(Id id, bool visible) {
+        Widget* w = find(id);
+        if (!w || w->visible == visible) return;
+        w->visible = visible;
+        fb.invalidate(w->bounds);
+    }
+
+    // The widget's content changed (pressed state, new text): its area must be redrawn.
+    void invalidate(Id id) {
+        Widget* w = find(id);
+        if (w && w->visible) fb.invalidate(w->bounds);
+    }
+
+    bool contains(Id id) const { return find(id) != nullptr; }
+    Rect bounds(Id id) const {
+        const Widget* w = find(id);
+        return w ? w->bounds : Rect();
+    }
+    int z(Id id) const {
+        const Widget* w = find(id);
+        return w ? w->z : 0;
+    }
+    bool visible(Id id) const {
+        const Widget* w = find(id);
+        return w && w->visible;
+    }
+    size_t size() const { return live; }
+
+    // Frontmost visible widget containing (x, y), or kNone.
+    Id hitTest(int x, int y) const {
+        if (x < 0 || y < 0 || x >= fb.width() || y >= fb.height()) return kNone;
+        Id best = kNone;
+        for (Id id : cells[(size_t)(y / cellSize) * columns + x / cellSize]) {
+            const Widget& w = widgets[id - 1];
+            if (w.visible && w.bounds.contains(x, y) && (best == kNone || inFront(w, widgets[best - 1]))) best = id;
+        }
+        return best;
+    }
+
+    // Visible widgets intersecting 'area', back to front.
+    std::vector<Id> query(const Rect& area) const {
+        std::vector<Id> found;
+        collect(area, found);
+        sortBackToFront(found);
+        return found;
+    }
+
+    // Widgets to redraw, back to front, after the dirty rectangles have been cleared to the background:
+    // every visible widget touching a dirty rectangle, plus every widget in front of one of those that
+    // overlaps it (it is painted over when the one behind it is redrawn).
+    std::vector<Id> damaged(const DirtyRegion& dirty) const {
+        std::vector<Id> found;
+        ++stamp;
+        for (const Rect& r : dirty.list()) collect(r, found, false);
+        for (size_t i = 0; i < found.size(); ++i) {   // 'found' grows while it is walked
+            const Widget& behind = widgets[found[i] - 1];
+            forEachInCells(behind.bounds, [&](Id id, const Widget& w) {
+                if (w.stamp != stamp && inFront(w, behind) && w.bounds.intersects(behind.bounds)) {
+                    w.stamp = stamp;
+                    found.push_back(id);
+                }
+            });
+        }
+        sortBackToFront(found);
+        return found;
+    }
+
+private:
+    struct Widget {
+        Rect bounds;
+        int z;
+        uint64_t order;          // add / raise sequence: breaks ties within the same z
+        bool visible;
+        bool alive;
+        mutable uint32_t stamp;  // last query that reported it, to report it once
+    };
+
+    struct CellRange {
+        int x0 = 0, y0 = 0, x1 = 0, y1 = 0;   // [x0, x1) x [y0, y1)
+        bool contains(int cx, int cy) const { return cx >= x0 && cx < x1 && cy >= y0 && cy < y1; }
+    };
+
+    static bool inFront(const Widget& a, const Widget& b) {
+        return a.z != b.z ? a.z > b.z : a.order > b.order;
+    }
+
+    const Widget* find(Id id) const {
+        if (id == kNone || id > widgets.size() || !widgets[id - 1].alive) return nullptr;
+        return &widgets[id - 1];
+    }
+    Widget* find(Id id) { return const_cast<Widget*>(static_cast<const WidgetIndex*>(this)->find(id)); }
+
+    // Cells overlapped by r; empty when r is off the screen.
+    CellRange cellRange(const Rect& r) const {
+        CellRange c;
+        Rect clipped = r.intersect(fb.bounds());
+        if (clipped.empty()) return c;
+        c.x0 = clipped.x / cellSize;
+        c.y0 = clipped.y / cellSize;
+        c.x1 = (clipped.right() - 1) / cellSize + 1;
+        c.y1 = (clipped.bottom() - 1) / cellSize + 1;
+        return c;
+    }
+
+    std::vector<Id>& cell(int cx, int cy) { return cells[(size_t)cy * columns + cx]; }
+
+    void insert(Id id, const Rect& r) {
+        CellRange c = cellRange(r);
+        for (int cy = c.y0; cy < c.y1; ++cy) {
+            for (int cx = c.x0; cx < c.x1; ++cx) cell(cx, cy).push_back(id);
+        }
+    }
+
+    void erase(Id id, const Rect& r) {
+        CellRange c = cellRange(r);
+        for (int cy = c.y0; cy < c.y1; ++cy) {
+            for (int cx = c.x0; cx < c.x1; ++cx) eraseFromCell(cell(cx, cy), id);
+        }
+    }
+
+    static void eraseFromCell(std::vector<Id>& list, Id id) {
+        auto it = std::find(list.begin(), list.end(), id);
+        if (it == list.end()) return;
+        *it = list.back();   // order within a cell does not matter
+        list.pop_back();
+    }
+
+    // Calls f(id, widget) for every visible widget in the cells under r; a widget spanning several cells
+    // may be passed more than once.
+    template <typename F>
+    void forEachInCells(const Rect& r, F f) const {
+        CellRange c = cellRange(r);
+        for (int cy = c.y0; cy < c.y1; ++cy) {
+            for (int cx = c.x0; cx < c.x1; ++cx) {
+                for (Id id : cells[(size_t)cy * columns + cx]) {
+                    const Widget& w = widgets[id - 1];
+                    if (w.visible) f(id, w);
+                }
+            }
+        }
+    }
+
+    void collect(const Rect& area, std::vector<Id>& found, bool newQuery = true) const {
+        if (newQuery) ++stamp;
+        forEachInCells(area, [&](Id id, const Widget& w) {
+            if (w.stamp != stamp && w.bounds.intersects(area)) {
+                w.stamp = stamp;
+                found.push_back(id);
+            }
+        });
+    }
+
+    void sortBackToFront(std::vector<Id>& ids) const {
+        std::sort(ids.begin(), ids.end(), [this](Id a, Id b) { return inFront(widgets[b - 1], widgets[a - 1]); });
+    }
+
+    Framebuffer& fb;
+    const int cellSize;
+    const int columns, rows;
+    std::vector<std::vector<Id>> cells;   // row-major, the ids of the widgets overlapping each cell
+    std::vector<Widget> widgets;          // widgets[id - 1]
+    size_t live = 0;
+    uint64_t nextOrder = 0;
+    mutable uint32_t stamp = 0;
+};
+
+} // namespace gfx
+
+#endif // WIDGET_INDEX_H
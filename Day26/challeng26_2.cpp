@@ -0,0 +1,158 @@
+// The pixel kernels of PixelKernels.h: first every SIMD version is checked bit for bit against the scalar
+// reference (random pixels, every length from 0 to 100, unaligned pointers), then all versions are timed
+// on full 480x320 screens to see which frame rates the fill / blit / blend / convert loops allow.
+//     g++ -std=c++17 -O2 challeng26_2.cpp -o challeng26_2
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include "PixelKernels.h"
+#include "Framebuffer.h"
+
+using namespace std;
+using pixelkernels::Kernels;
+
+const int kWidth = 480;
+const int kHeight = 320;
+const size_t kScreen = (size_t)kWidth * kHeight;
+
+mt19937 rng(26);
+
+template <typename T>
+vector<T> randomPixels(size_t n) {
+    vector<T> v(n);
+    for (auto& p : v) p = (T)rng();
+    return v;
+}
+
+// Runs 'k' and the scalar reference on copies of the same data and compares the outputs.
+bool checkAgainstScalar(const Kernels& k) {
+    const Kernels& ref = pixelkernels::scalarKernels();
+    const size_t kMax = 100, kPad = 3;   // pointers are offset by 0..3 elements to test unaligned access
+    int failures = 0;
+    auto expect = [&failures, &k](bool same, const char* kernel, size_t n) {
+        if (!same && failures++ < 5) cout << "  " << k.name << " " << kernel << " differs for n=" << n << endl;
+    };
+
+    for (size_t off = 0; off <= kPad; ++off) {
+        for (size_t n = 0; n <= kMax; ++n) {
+            vector<uint16_t> d16 = randomPixels<uint16_t>(kMax + kPad), e16 = d16;
+            vector<uint32_t> s32 = randomPixels<uint32_t>(kMax + kPad);
+            vector<uint16_t> s16 = randomPixels<uint16_t>(kMax + kPad);
+            vector<uint32_t> d32(kMax + kPad), e32(kMax + kPad);
+            // Make sure alpha 0 and 255 (the usual values) are well covered.
+            for (size_t i = 0; i < s32.size(); i += 3) s32[i] |= 0xFF000000u;
+            for (size_t i = 1; i < s32.size(); i += 5) s32[i] &= 0x00FFFFFFu;
+
+            k.fill16(&d16[off], n, 0xA5C3);
+            ref.fill16(&e16[off], n, 0xA5C3);
+            expect(d16 == e16, "fill16", n);
+
+            k.fill32(&d32[off], n, 0x80FF1234u);
+            ref.fill32(&e32[off], n, 0x80FF1234u);
+            expect(d32 == e32, "fill32", n);
+
+            k.copy16(&d16[off], &s16[kPad - off], n);
+            ref.copy16(&e16[off], &s16[kPad - off], n);
+            expect(d16 == e16, "copy16", n);
+
+            k.copy32(&d32[off], &s32[kPad - off], n);
+            ref.copy32(&e32[off], &s32[kPad - off], n);
+            expect(d32 == e32, "copy32", n);
+
+            k.blendOver565(&d16[off], &s32[kPad - off], n);
+            ref.blendOver565(&e16[off], &s32[kPad - off], n);
+            expect(d16 == e16, "blendOver565", n);
+
+            k.rgb565ToArgb8888(&d32[off], &s16[off], n);
+            ref.rgb565ToArgb8888(&e32[off], &s16[off], n);
+            expect(d32 == e32, "rgb565ToArgb8888", n);
+
+            k.argb8888ToRgb565(&d16[off], &s32[off], n);
+            ref.argb8888ToRgb565(&e16[off], &s32[off], n);
+            expect(d16 == e16, "argb8888ToRgb565", n);
+        }
+    }
+
+    // Every 565 colour must survive a round trip through ARGB8888.
+    vector<uint16_t> all(65536), back(65536);
+    vector<uint32_t> wide(65536);
+    for (size_t i = 0; i < all.size(); ++i) all[i] = (uint16_t)i;
+    k.rgb565ToArgb8888(wide.data(), all.data(), all.size());
+    k.argb8888ToRgb565(back.data(), wide.data(), all.size());
+    expect(all == back, "565 -> 8888 -> 565 round trip", all.size());
+
+    return failures == 0;
+}
+
+template <typename F>
+double medianMs(F f) {
+    vector<double> times;
+    for (int i = 0; i < 21; ++i) {
+        auto start = chrono::steady_clock::now();
+        f();
+        times.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+    }
+    sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+int main() {
+    vector<const Kernels*> kernels = pixelkernels::availableKernels();
+
+    cout << "Equivalence with the scalar reference:" << endl;
+    bool allOk = true;
+    for (const Kernels* k : kernels) {
+        bool ok = checkAgainstScalar(*k);
+        allOk = allOk && ok;
+        cout << "  " << setw(6) << k->name << ": " << (ok ? "identical" : "MISMATCH") << endl;
+    }
+
+    vector<uint16_t> screen(kScreen), image = randomPixels<uint16_t>(kScreen);
+    vector<uint32_t> argb = randomPixels<uint32_t>(kScreen), argbOut(kScreen);
+
+    cout << "\nms per full " << kWidth << "x" << kHeight << " screen (median of 21):" << endl;
+    cout << setw(8) << "" << setw(10) << "fill" << setw(10) << "blit" << setw(10) << "blend"
+         << setw(10) << "565->8888" << setw(10) << "8888->565" << endl;
+    cout << fixed << setprecision(3);
+    for (const Kernels* k : kernels) {
+        cout << setw(8) << k->name
+             << setw(10) << medianMs([&] { k->fill16(screen.data(), kScreen, 0x1234); })
+             << setw(10) << medianMs([&] { k->copy16(screen.data(), image.data(), kScreen); })
+             << setw(10) << medianMs([&] { k->blendOver565(screen.data(), argb.data(), kScreen); })
+             << setw(10) << medianMs([&] { k->rgb565ToArgb8888(argbOut.data(), image.data(), kScreen); })
+             << setw(10) << medianMs([&] { k->argb8888ToRgb565(screen.data(), argb.data(), kScreen); }) << endl;
+    }
+
+    // A frame as the UI draws it: background, a few buttons and a half-transparent overlay, through Framebuffer.
+    gfx::Framebuffer fb(kWidth, kHeight);
+    vector<uint32_t> overlay(200 * 100, 0x80000000u);   // 50% black
+    double frameMs = medianMs([&] {
+        fb.fillScreen(gfx::kNavy);
+        for (int i = 0; i < 6; ++i) {
+            fb.fillRect(20 + (i % 3) * 150, 40 + (i / 3) * 120, 130, 90, gfx::kBlue);
+            fb.drawRect(20 + (i % 3) * 150, 40 + (i / 3) * 120, 130, 90, gfx::kWhite);
+        }
+        fb.blendARGBBitmap(400, 250, overlay.data(), 200, 100);   // clipped at the right and bottom edge
+    });
+    cout << "\nUI frame with " << pixelkernels::pixelKernels().name << ": " << frameMs << " ms ("
+         << (int)(1000 / frameMs) << " frames/s of drawing)" << endl;
+
+    cout << (allOk ? "All kernels identical" : "Kernels DIFFER") << endl;
+    return allOk ? 0 : 1;
+}
+
+
+/*Why the SIMD versions are faster, and why they must match exactly:
+
+1. fill and blit are limited by memory bandwidth: one 16 or 32 byte store instead of one 2 byte store per pixel.
+2. Blending needs several multiplies per channel. In 16-bit lanes SSE2 does 8 pixels and AVX2 16 pixels per
+   instruction; the channels are split, blended and packed back without leaving the registers.
+3. Division by 255 is done with a shift trick that gives the exact rounded result, so every version produces
+   the same bits. A UI that looks slightly different on the simulator than on the device is a nightmare to test.
+4. The CPU is checked once (AVX2 is optional on x86); on ARM, NEON is always present on AArch64, so it is
+   selected at compile time.
+*/
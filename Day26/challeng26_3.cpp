@@ -0,0 +1,126 @@
+// LVGL.cpp's flush path with one, two and three draw buffers (FlushPipeline.h). A 240x320 panel on a
+// 40 MHz SPI bus (5 MB/s, about 31 ms per full frame) is fed in strips of 10 lines, the strip height of
+// buf[LV_HOR_RES_MAX * 10]. Rendering is real drawing plus a busy wait that stands in for the slower
+// MCU: plain background strips cost little, strips with widgets cost more, about 23 ms per frame in total.
+//     g++ -std=c++17 -O2 -pthread challeng26_3.cpp -o challeng26_3
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include "FlushPipeline.h"
+#include "PixelKernels.h"
+
+using namespace std;
+
+const int kWidth = 240;
+const int kHeight = 320;
+const int kStripLines = 10;
+const double kBusBytesPerSecond = 5e6;
+const int kFrames = 30;
+
+// Simulated MCU cost per strip: a plain strip 0.3 ms, one with widgets on it 1.2 ms.
+const chrono::microseconds kPlainStripCost(300);
+const chrono::microseconds kWidgetStripCost(1200);
+
+struct Widget {
+    gfx::Rect rect;
+    uint16_t color;
+};
+
+// The scene of frame 'frame': a few fixed buttons and one that moves, like an animation in LVGL.
+vector<Widget> sceneOf(int frame) {
+    return {
+        {{20, 20, 200, 40}, gfx::kBlue},
+        {{20, 80, 90, 60}, gfx::kDarkGreen},
+        {{130, 80, 90, 60}, gfx::kDarkGreen},
+        {{(frame * 7) % (kWidth - 60), 180 + (frame * 3) % 80, 60, 40}, gfx::kWhite},
+    };
+}
+
+// Renders rows [y, y + lines) of the scene into 'pixels' (kWidth pixels per row). Returns true if a widget
+// was drawn, to decide how long the MCU would have needed.
+bool renderStrip(const vector<Widget>& scene, int y, int lines, uint16_t* pixels) {
+    const pixelkernels::Kernels& k = pixelkernels::pixelKernels();
+    for (int row = 0; row < lines; ++row) {
+        k.fill16(pixels + (size_t)row * kWidth, kWidth, gfx::rgb565(0, 0, (uint8_t)((y + row) * 255 / kHeight)));
+    }
+    gfx::Rect strip{0, y, kWidth, lines};
+    bool any = false;
+    for (const Widget& w : scene) {
+        gfx::Rect r = w.rect.intersect(strip);
+        if (r.empty()) continue;
+        for (int row = r.y; row < r.bottom(); ++row) {
+            k.fill16(pixels + (size_t)(row - y) * kWidth + r.x, r.w, w.color);
+        }
+        any = true;
+    }
+    return any;
+}
+
+void spinFor(chrono::microseconds d) {
+    auto end = chrono::steady_clock::now() + d;
+    while (chrono::steady_clock::now() < end) {
+    }
+}
+
+void renderFrames(gfx::FlushPipeline& pipeline) {
+    for (int frame = 0; frame < kFrames; ++frame) {
+        vector<Widget> scene = sceneOf(frame);
+        for (int y = 0; y < kHeight; y += kStripLines) {
+            gfx::DrawBuffer* buf = pipeline.acquire();
+            int lines = min(kStripLines, kHeight - y);
+            bool widgets = renderStrip(scene, y, lines, buf->pixels.data());
+            spinFor(widgets ? kWidgetStripCost : kPlainStripCost);
+            pipeline.flush(buf, gfx::Rect{0, y, kWidth, lines}, y + lines == kHeight);
+        }
+    }
+}
+
+int main() {
+    // What the panel must show at the end: the last frame rendered in one go.
+    vector<uint16_t> expected((size_t)kWidth * kHeight);
+    renderStrip(sceneOf(kFrames - 1), 0, kHeight, expected.data());
+
+    cout << fixed << setprecision(1);
+    cout << "buffers  frame ms (median / p99 / max)   fps   render ms  stall ms  transfer ms  overlap" << endl;
+    bool allOk = true;
+    for (int buffers = 1; buffers <= 3; ++buffers) {
+        gfx::PpmSink panel(kWidth, kHeight);
+        gfx::PipelineStats s;
+        {
+            gfx::FlushPipeline pipeline(panel, kWidth, kStripLines, buffers, kBusBytesPerSecond);
+            renderFrames(pipeline);
+            s = pipeline.statistics();
+        }
+
+        bool ok = true;
+        for (int y = 0; y < kHeight && ok; ++y) {
+            for (int x = 0; x < kWidth && ok; ++x) ok = panel.pixel(x, y) == expected[(size_t)y * kWidth + x];
+        }
+        allOk = allOk && ok;
+
+        cout << setw(7) << buffers << "  " << setw(8) << s.frameMsMedian << " / " << setw(5) << s.frameMsP99
+             << " / " << setw(5) << s.frameMsMax << "   " << setw(5) << s.fps << "  " << setw(9) << s.renderMs
+             << "  " << setw(8) << s.stallMs << "  " << setw(11) << s.transferMs << "  " << setw(5)
+             << (s.renderMs > 0 ? 100 * s.overlapMs / s.renderMs : 0) << "% of render"
+             << (ok ? "" : "  PANEL WRONG") << endl;
+    }
+
+    cout << (allOk ? "Panel content correct with every buffer count" : "Panel content WRONG") << endl;
+    return allOk ? 0 : 1;
+}
+
+
+/*Why a second draw buffer is the biggest frame-rate lever:
+
+1. With one buffer the renderer may not touch it until the strip is on the panel, so every frame costs
+   render time + transfer time (about 23 + 31 ms here).
+2. With two buffers the next strip is drawn while the previous one is sent, so a frame costs about
+   max(render, transfer): the bus now sets the frame rate, and the renderer's time is mostly hidden ("overlap").
+3. A third buffer helps when strips are uneven: a cheap strip can be drawn ahead while an expensive one is
+   still being sent, so the bus rarely waits for the renderer. It costs another strip of RAM
+   (240 * 10 * 2 = 4.8 KB here).
+4. On the device the completion comes from the DMA interrupt calling lv_disp_flush_ready(); the renderer
+   must never write a buffer before that, which is exactly what acquire() waits for.
+*/
@@ -0,0 +1,165 @@
+// A dense dashboard with WidgetIndex.h: a title bar, 360 toggle tiles (12 x 30) and a popup in front of them.
+// Touches are hit-tested through the grid and checked against the linear scan loop() would otherwise need.
+// Tapping tiles and dragging the popup only marks the affected areas dirty; damaged() names the widgets to
+// redraw, and after every frame the panel is compared with a reference that redraws everything.
+//     g++ -std=c++17 -O2 challeng26_5.cpp -o challeng26_5
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstring>
+#include "WidgetIndex.h"
+
+using namespace std;
+using gfx::WidgetIndex;
+
+const int kWidth = 240;
+const int kHeight = 320;
+const int kTileColumns = 12, kTileRows = 30, kTileW = 20, kTileH = 10, kTitleH = 20;
+
+enum class Kind { Title, Tile, Popup };
+
+struct WidgetInfo {   // what the application keeps per widget; the index only knows rectangles and z
+    Kind kind;
+    bool on = false;
+};
+
+gfx::Framebuffer tft(kWidth, kHeight);
+gfx::PpmSink panel(kWidth, kHeight);
+WidgetIndex widgets(tft);
+vector<WidgetInfo> info(1);   // info[id]; id 0 is kNone
+
+void paint(gfx::Framebuffer& fb, const gfx::Rect& r, const WidgetInfo& w) {
+    switch (w.kind) {
+    case Kind::Title:
+        fb.fillRect(r.x, r.y, r.w, r.h, gfx::kBlue);
+        fb.setCursor(r.x + 4, r.y + 6);
+        fb.setTextColor(gfx::kWhite);
+        fb.setTextSize(1);
+        fb.print("Dashboard");
+        break;
+    case Kind::Tile:
+        fb.fillRect(r.x, r.y, r.w, r.h, w.on ? gfx::kDarkGreen : gfx::kNavy);
+        fb.drawRect(r.x, r.y, r.w, r.h, gfx::kBlack);
+        break;
+    case Kind::Popup:
+        fb.fillRect(r.x, r.y, r.w, r.h, gfx::kBlue);
+        fb.drawRect(r.x, r.y, r.w, r.h, gfx::kWhite);
+        fb.setCursor(r.x + 10, r.y + 10);
+        fb.setTextColor(gfx::kWhite);
+        fb.setTextSize(2);
+        fb.print("Popup");
+        break;
+    }
+}
+
+WidgetIndex::Id addWidget(const gfx::Rect& r, Kind kind, int z = 0) {
+    WidgetIndex::Id id = widgets.add(r, z);
+    info.push_back(WidgetInfo{kind});
+    return id;
+}
+
+// Partial redraw: background under the dirty rectangles, then the damaged widgets back to front.
+size_t repaint() {
+    vector<WidgetIndex::Id> redraw = widgets.damaged(tft.dirty());
+    vector<gfx::Rect> dirty = tft.dirty().list();   // a copy: fillRect adds to the dirty list
+    for (const gfx::Rect& r : dirty) tft.fillRect(r.x, r.y, r.w, r.h, gfx::kBlack);
+    for (WidgetIndex::Id id : redraw) paint(tft, widgets.bounds(id), info[id]);
+    return redraw.size();
+}
+
+// Reference: the whole screen from scratch.
+void redrawAll(gfx::Framebuffer& fb) {
+    fb.fillScreen(gfx::kBlack);
+    for (WidgetIndex::Id id : widgets.query(fb.bounds())) paint(fb, widgets.bounds(id), info[id]);
+}
+
+// What loop() would do without the index: test every widget, keep the frontmost hit.
+WidgetIndex::Id linearHitTest(int x, int y) {
+    WidgetIndex::Id best = WidgetIndex::kNone;
+    for (WidgetIndex::Id id = 1; id < info.size(); ++id) {
+        if (widgets.visible(id) && widgets.bounds(id).contains(x, y) &&
+            (best == WidgetIndex::kNone || widgets.z(id) >= widgets.z(best))) {
+            best = id;
+        }
+    }
+    return best;
+}
+
+int main() {
+    addWidget(gfx::Rect(0, 0, kWidth, kTitleH), Kind::Title);
+    for (int row = 0; row < kTileRows; ++row) {
+        for (int col = 0; col < kTileColumns; ++col) {
+            addWidget(gfx::Rect(col * kTileW, kTitleH + row * kTileH, kTileW, kTileH), Kind::Tile);
+        }
+    }
+    WidgetIndex::Id popup = addWidget(gfx::Rect(20, 60, 100, 60), Kind::Popup, 1);
+    cout << widgets.size() << " widgets" << endl;
+
+    // Hit-testing: the grid against the linear scan.
+    mt19937 rng(26);
+    vector<pair<int, int>> touches(1000000);
+    for (auto& t : touches) t = {(int)(rng() % kWidth), (int)(rng() % kHeight)};
+    bool sameHits = true;
+    uint64_t sum = 0;
+    auto start = chrono::steady_clock::now();
+    for (auto& t : touches) sum += widgets.hitTest(t.first, t.second);
+    double gridNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / touches.size();
+    start = chrono::steady_clock::now();
+    for (auto& t : touches) sum -= linearHitTest(t.first, t.second);
+    double linearNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / touches.size();
+    for (size_t i = 0; i < 10000; ++i) sameHits = sameHits && widgets.hitTest(touches[i].first, touches[i].second) ==
+                                                                  linearHitTest(touches[i].first, touches[i].second);
+    cout << fixed << setprecision(1) << "hit test: grid " << gridNs << " ns, linear scan " << linearNs << " ns per touch"
+         << (sameHits && sum == 0 ? ", same results" : ", DIFFERENT results") << endl;
+
+    // First frame: everything is dirty.
+    repaint();
+    tft.flush(panel);
+
+    gfx::Framebuffer reference(kWidth, kHeight);
+    bool panelOk = true;
+    size_t frames = 0, repainted = 0;
+    long pixelsSent = 0;
+    for (int frame = 0; frame < 60; ++frame) {
+        if (frame % 2 == 0) {   // a tap: toggle whatever is under the finger
+            WidgetIndex::Id hit = widgets.hitTest((int)(rng() % kWidth), (int)(rng() % kHeight));
+            if (hit != WidgetIndex::kNone && info[hit].kind == Kind::Tile) {
+                info[hit].on = !info[hit].on;
+                widgets.invalidate(hit);
+            }
+        }
+        gfx::Rect p = widgets.bounds(popup);   // the popup is dragged diagonally
+        widgets.move(popup, gfx::Rect(p.x + 2, p.y + 3, p.w, p.h));
+        if (frame == 40) widgets.setVisible(popup, false);   // and closed
+
+        repainted += repaint();
+        pixelsSent += tft.flush(panel).pixels;
+        ++frames;
+
+        redrawAll(reference);
+        for (int y = 0; y < kHeight; ++y) {
+            panelOk = panelOk && memcmp(&reference.pixels()[(size_t)y * kWidth], &tft.pixels()[(size_t)y * kWidth],
+                                        kWidth * sizeof(uint16_t)) == 0;
+            for (int x = 0; x < kWidth && panelOk; ++x) panelOk = panel.pixel(x, y) == reference.pixel(x, y);
+        }
+    }
+    cout << "per frame: " << (double)repainted / frames << " of " << widgets.size() << " widgets redrawn, "
+         << pixelsSent / (long)frames << " of " << kWidth * kHeight << " pixels sent" << endl;
+    cout << (panelOk ? "Panel matches a full redraw in every frame" : "Panel DIFFERS from a full redraw") << endl;
+    return panelOk && sameHits ? 0 : 1;
+}
+
+
+/*Why a spatial index for widgets:
+
+1. A touch has to find the frontmost widget under the finger. Scanning all widgets is fine for three buttons
+   and wasteful for hundreds; the grid looks only at the few widgets registered in one 32x32 cell.
+2. A uniform grid suits a screen: the area is fixed and small, widgets are mostly small and spread out, so a
+   cell holds only a handful of entries. Moving a widget updates only the cells it enters or leaves.
+3. Z-order lives in the index too, so "frontmost" is decided in one place for hit-testing and for drawing.
+4. The same index answers "what must be redrawn" for the dirty rectangles: the widgets under them, plus
+   those in front of a redrawn widget. A dragged popup costs a few dozen tiles per frame, not the screen.
+*/
@@ -0,0 +1,38 @@
+#ifndef SHAPE_H
+#define SHAPE_H
+
+// The Shape / Circle / Rectangle hierarchy of challeng4_2.cpp, in a header so other programs can reuse it.
+// The getters let code outside the class (for example ShapeBatch) read the dimensions.
+
+class Shape {
+public:
+    virtual double area() const = 0;  // Pure virtual function
+    virtual ~Shape() {}  // Virtual destructor
+};
+
+class Circle : public Shape {
+    double radius_;
+public:
+    Circle(double r) : radius_(r) {}  // Constructor to initialize radius
+
+    double area() const override {
+        return 3.14 * radius_ * radius_;
+    }
+
+    double radius() const { return radius_; }
+};
+
+class Rectangle : public Shape {
+    double length_, width_;
+public:
+    Rectangle(double l, double w) : length_(l), width_(w) {}  // Constructor to initialize length and width
+
+    double area() const override {
+        return length_ * width_;
+    }
+
+    double length() const { return length_; }
+    double width() const { return width_; }
+};
+
+#endif // SHAPE_H
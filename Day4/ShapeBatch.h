@@ -0,0 +1,221 @@
+#ifndef SHAPE_BATCH_H
+#define SHAPE_BATCH_H
+
+// Data-oriented storage for many shapes at once.
+//
+// An array of Shape* (challeng4_2.cpp) means one heap object per shape and one virtual call per area().
+// ShapeBatch instead keeps one column per attribute (structure of arrays):
+//     circles:    radius[]
+//     rectangles: length[], width[]
+// and computes all areas with SIMD kernels: AVX (4 doubles per instruction) when the CPU supports it,
+// SSE2 (2 doubles) otherwise on x86, and a plain loop on other architectures.
+// The CPU check happens once; the kernels are selected at runtime, so the program does not need -mavx.
+
+#include <cstddef>
+#include <vector>
+#include "Shape.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SHAPE_BATCH_X86 1
+#include <immintrin.h>
+#endif
+
+namespace shapekernels {
+
+const double kPi = 3.14;   // same constant as Circle::area()
+
+// Reference versions; the SIMD versions must give the same results.
+inline void circleAreasScalar(const double* r, double* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) out[i] = kPi * r[i] * r[i];
+}
+
+inline void rectangleAreasScalar(const double* l, const double* w, double* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) out[i] = l[i] * w[i];
+}
+
+inline double circleTotalScalar(const double* r, size_t n) {
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i) sum += r[i] * r[i];
+    return kPi * sum;
+}
+
+inline double rectangleTotalScalar(const double* l, const double* w, size_t n) {
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i) sum += l[i] * w[i];
+    return sum;
+}
+
+#ifdef SHAPE_BATCH_X86
+
+inline void circleAreasSse2(const double* r, double* out, size_t n) {
+    const __m128d pi = _mm_set1_pd(kPi);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d v = _mm_loadu_pd(r + i);
+        _mm_storeu_pd(out + i, _mm_mul_pd(_mm_mul_pd(pi, v), v));
+    }
+    circleAreasScalar(r + i, out + i, n - i);
+}
+
+inline void rectangleAreasSse2(const double* l, const double* w, double* out, size_t n) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(l + i), _mm_loadu_pd(w + i)));
+    }
+    rectangleAreasScalar(l + i, w + i, out + i, n - i);
+}
+
+__attribute__((target("avx"))) inline void circleAreasAvx(const double* r, double* out, size_t n) {
+    const __m256d pi = _mm256_set1_pd(kPi);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(r + i);
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_mul_pd(pi, v), v));
+    }
+    circleAreasScalar(r + i, out + i, n - i);
+}
+
+__attribute__((target("avx"))) inline void rectangleAreasAvx(const double* l, const double* w, double* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(l + i), _mm256_loadu_pd(w + i)));
+    }
+    rectangleAreasScalar(l + i, w + i, out + i, n - i);
+}
+
+// Totals use two independent accumulators so consecutive adds do not wait for each other.
+__attribute__((target("avx"))) inline double productSumAvx(const double* a, const double* b, size_t n) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4)));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + rectangleTotalScalar(a + i, b + i, n - i);
+}
+
+inline double productSumSse2(const double* a, const double* b, size_t n) {
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+    return lanes[0] + lanes[1] + rectangleTotalScalar(a + i, b + i, n - i);
+}
+
+inline bool hasAvx() {
+    static const bool avx = __builtin_cpu_supports("avx");
+    return avx;
+}
+
+#endif // SHAPE_BATCH_X86
+
+inline void circleAreas(const double* r, double* out, size_t n) {
+#ifdef SHAPE_BATCH_X86
+    if (hasAvx()) return circleAreasAvx(r, out, n);
+    return circleAreasSse2(r, out, n);
+#else
+    circleAreasScalar(r, out, n);
+#endif
+}
+
+inline void rectangleAreas(const double* l, const double* w, double* out, size_t n) {
+#ifdef SHAPE_BATCH_X86
+    if (hasAvx()) return rectangleAreasAvx(l, w, out, n);
+    return rectangleAreasSse2(l, w, out, n);
+#else
+    rectangleAreasScalar(l, w, out, n);
+#endif
+}
+
+inline double circleTotal(const double* r, size_t n) {
+#ifdef SHAPE_BATCH_X86
+    return kPi * (hasAvx() ? productSumAvx(r, r, n) : productSumSse2(r, r, n));
+#else
+    return circleTotalScalar(r, n);
+#endif
+}
+
+inline double rectangleTotal(const double* l, const double* w, size_t n) {
+#ifdef SHAPE_BATCH_X86
+    return hasAvx() ? productSumAvx(l, w, n) : productSumSse2(l, w, n);
+#else
+    return rectangleTotalScalar(l, w, n);
+#endif
+}
+
+} // namespace shapekernels
+
+class ShapeBatch {
+public:
+    void reserve(size_t circles, size_t rectangles) {
+        radius.reserve(circles);
+        length.reserve(rectangles);
+        width.reserve(rectangles);
+    }
+
+    void addCircle(double r) { radius.push_back(r); }
+    void addRectangle(double l, double w) {
+        length.push_back(l);
+        width.push_back(w);
+    }
+
+    // Interop with the virtual hierarchy: copies the dimensions of a Circle or Rectangle into the columns.
+    // Returns false for any other Shape type.
+    bool add(const Shape& shape) {
+        if (const Circle* c = dynamic_cast<const Circle*>(&shape)) {
+            addCircle(c->radius());
+            return true;
+        }
+        if (const Rectangle* r = dynamic_cast<const Rectangle*>(&shape)) {
+            addRectangle(r->length(), r->width());
+            return true;
+        }
+        return false;
+    }
+
+    size_t circleCount() const { return radius.size(); }
+    size_t rectangleCount() const { return length.size(); }
+    size_t size() const { return circleCount() + rectangleCount(); }
+
+    // Rebuild a regular object when some code still needs a Shape.
+    Circle circle(size_t i) const { return Circle(radius[i]); }
+    Rectangle rectangle(size_t i) const { return Rectangle(length[i], width[i]); }
+
+    // Writes circleCount() areas, then rectangleCount() areas, into 'out' (which must hold size() doubles).
+    void areas(double* out) const {
+        shapekernels::circleAreas(radius.data(), out, radius.size());
+        shapekernels::rectangleAreas(length.data(), width.data(), out + radius.size(), length.size());
+    }
+
+    std::vector<double> areas() const {
+        std::vector<double> out(size());
+        areas(out.data());
+        return out;
+    }
+
+    double totalArea() const {
+        return shapekernels::circleTotal(radius.data(), radius.size()) +
+               shapekernels::rectangleTotal(length.data(), width.data(), length.size());
+    }
+
+    void clear() {
+        radius.clear();
+        length.clear();
+        width.clear();
+    }
+
+private:
+    std::vector<double> radius;   // circles
+    std::vector<double> length;   // rectangles
+    std::vector<double> width;
+};
+
+#endif // SHAPE_BATCH_H
@@ -0,0 +1,139 @@
+#ifndef STATIC_SHAPES_H
+#define STATIC_SHAPES_H
+
+// Static-dispatch alternative to the virtual Shape hierarchy in Shape.h.
+//
+// - Every shape is a plain value type with a non-virtual area(). The CRTP base StaticShape<Derived>
+//   gives them a common interface without a vtable, so calls are resolved (and inlined) at compile time.
+// - The set of shapes is a compile-time type list: TypeList<Circle, Rectangle, ...>.
+//   ShapeList<List> holds the shapes by value in a std::variant made from that list, and
+//   ShapeColumns<List> keeps one std::vector per type.
+// - Adding a shape type means writing the struct and adding it to your TypeList; std::visit and the
+//   fold expressions below generate the dispatch, there is no central switch to edit.
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace static_shapes {
+
+template <typename... Ts>
+struct TypeList {};
+
+// TypeList<A, B> -> std::variant<A, B>, std::tuple<std::vector<A>, std::vector<B>>
+template <typename List> struct AsVariant;
+template <typename... Ts> struct AsVariant<TypeList<Ts...>> { using type = std::variant<Ts...>; };
+
+template <typename List> struct AsColumns;
+template <typename... Ts> struct AsColumns<TypeList<Ts...>> { using type = std::tuple<std::vector<Ts>...>; };
+
+template <typename T, typename List> struct Contains;
+template <typename T, typename... Ts> struct Contains<T, TypeList<Ts...>> : std::disjunction<std::is_same<T, Ts>...> {};
+
+// CRTP base: area() forwards to Derived::areaImpl() with a static_cast, no virtual call.
+template <typename Derived>
+class StaticShape {
+public:
+    double area() const { return static_cast<const Derived&>(*this).areaImpl(); }
+};
+
+class Circle : public StaticShape<Circle> {
+public:
+    explicit Circle(double r) : radius(r) {}
+    double areaImpl() const { return 3.14 * radius * radius; }   // same constant as ::Circle
+    double radius;
+};
+
+class Rectangle : public StaticShape<Rectangle> {
+public:
+    Rectangle(double l, double w) : length(l), width(w) {}
+    double areaImpl() const { return length * width; }
+    double length, width;
+};
+
+using DefaultShapes = TypeList<Circle, Rectangle>;
+
+// Shapes of mixed types held by value in one contiguous vector. Each element is a variant, so the only
+// dispatch left is the variant index check inside std::visit (a jump table), not a pointer chase plus vtable.
+template <typename List = DefaultShapes>
+class ShapeList {
+public:
+    using Variant = typename AsVariant<List>::type;
+
+    template <typename T>
+    void add(T shape) {
+        static_assert(Contains<T, List>::value, "shape type is not in this ShapeList's TypeList");
+        shapes.emplace_back(std::move(shape));
+    }
+
+    // Calls visitor(shape) with the concrete type of every element.
+    template <typename Visitor>
+    void forEach(Visitor&& visitor) const {
+        for (const Variant& shape : shapes) {
+            std::visit(visitor, shape);
+        }
+    }
+
+    double totalArea() const {
+        double total = 0;
+        forEach([&total](const auto& shape) { total += shape.area(); });
+        return total;
+    }
+
+    size_t size() const { return shapes.size(); }
+    void reserve(size_t n) { shapes.reserve(n); }
+
+private:
+    std::vector<Variant> shapes;
+};
+
+// One vector per shape type. Batch operations run one tight, fully inlined loop per type,
+// with no per-element dispatch at all; the order between different types is not kept.
+template <typename List = DefaultShapes>
+class ShapeColumns {
+public:
+    template <typename T>
+    void add(T shape) {
+        static_assert(Contains<T, List>::value, "shape type is not in this ShapeColumns' TypeList");
+        std::get<std::vector<T>>(columns).push_back(std::move(shape));
+    }
+
+    template <typename T>
+    const std::vector<T>& of() const { return std::get<std::vector<T>>(columns); }
+
+    // Calls visitor(const std::vector<T>&) once for every type in the list.
+    template <typename Visitor>
+    void forEachType(Visitor&& visitor) const {
+        std::apply([&visitor](const auto&... column) { (visitor(column), ...); }, columns);
+    }
+
+    // Calls visitor(shape) for every element, type by type.
+    template <typename Visitor>
+    void forEach(Visitor&& visitor) const {
+        forEachType([&visitor](const auto& column) {
+            for (const auto& shape : column) visitor(shape);
+        });
+    }
+
+    double totalArea() const {
+        double total = 0;
+        forEach([&total](const auto& shape) { total += shape.area(); });
+        return total;
+    }
+
+    size_t size() const {
+        size_t n = 0;
+        forEachType([&n](const auto& column) { n += column.size(); });
+        return n;
+    }
+
+private:
+    typename AsColumns<List>::type columns;
+};
+
+} // namespace static_shapes
+
+#endif // STATIC_SHAPES_H
@@ -3,34 +3,9 @@
 
 
 #include <iostream>
+#include "Shape.h"
 using namespace std;
 
-class Shape {
-public:
-    virtual double area() const = 0;  // Pure virtual function
-    virtual ~Shape() {}  // Virtual destructor
-};
-
-class Circle : public Shape {
-    double radius;
-public:
-    Circle(double r) : radius(r) {}  // Constructor to initialize radius
-
-    double area() const override {
-        return 3.14 * radius * radius;
-    }
-};
-
-class Rectangle : public Shape {
-    double length, width;
-public:
-    Rectangle(double l, double w) : length(l), width(w) {}  // Constructor to initialize length and width
-
-    double area() const override {
-        return length * width;
-    }
-};
-
 int main() {
     // Create instances of Circle and Rectangle
     Shape* shapes[2];
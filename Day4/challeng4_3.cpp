@@ -0,0 +1,73 @@
+
+// Compute the areas of millions of shapes two ways: an array of Shape* with virtual area() (as in challeng4_2.cpp)
+// and a ShapeBatch that stores circles and rectangles in separate columns and uses SIMD kernels.
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cmath>
+#include "Shape.h"
+#include "ShapeBatch.h"
+
+using namespace std;
+
+int main() {
+    const int count = 2000000;
+
+    // Virtual path: one heap object and one indirect call per shape.
+    vector<unique_ptr<Shape>> shapes;
+    shapes.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        if (i % 2 == 0) {
+            shapes.push_back(make_unique<Circle>(1.0 + i % 10));
+        } else {
+            shapes.push_back(make_unique<Rectangle>(1.0 + i % 5, 2.0 + i % 3));
+        }
+    }
+
+    // Batch path: the same shapes copied into columns through the Shape interface.
+    ShapeBatch batch;
+    batch.reserve(count / 2, count / 2);
+    for (const auto &shape : shapes) {
+        batch.add(*shape);
+    }
+
+    auto t0 = chrono::steady_clock::now();
+    double virtualTotal = 0;
+    for (const auto &shape : shapes) {
+        virtualTotal += shape->area();
+    }
+    auto t1 = chrono::steady_clock::now();
+    double batchTotal = batch.totalArea();
+    auto t2 = chrono::steady_clock::now();
+    vector<double> areas = batch.areas();
+    auto t3 = chrono::steady_clock::now();
+
+    cout << "Virtual area() total: " << virtualTotal << " in "
+         << chrono::duration<double, milli>(t1 - t0).count() << " ms" << endl;
+    cout << "ShapeBatch total:     " << batchTotal << " in "
+         << chrono::duration<double, milli>(t2 - t1).count() << " ms" << endl;
+    cout << "ShapeBatch areas():   " << areas.size() << " areas in "
+         << chrono::duration<double, milli>(t3 - t2).count() << " ms" << endl;
+
+    // The SIMD kernels must agree with Shape::area() for every element.
+    bool same = true;
+    for (size_t i = 0; i < batch.circleCount(); ++i) {
+        same = same && areas[i] == batch.circle(i).area();
+    }
+    for (size_t i = 0; i < batch.rectangleCount(); ++i) {
+        same = same && areas[batch.circleCount() + i] == batch.rectangle(i).area();
+    }
+    cout << (same && fabs(batchTotal - virtualTotal) < 1e-9 * virtualTotal ? "Results match" : "Results differ") << endl;
+
+    return 0;
+}
+
+
+/*Array of structures vs structure of arrays:
+
+- vector<unique_ptr<Shape>>: every shape is a separate heap block, area() is a virtual call,
+  and the CPU has to follow a pointer before it can even load the radius.
+- ShapeBatch: all radii are next to each other in one vector, all lengths in another, all widths in a third.
+  One AVX instruction multiplies 4 radii at once, and the loop has no calls and no branches on the type.*/
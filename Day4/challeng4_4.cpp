@@ -0,0 +1,99 @@
+
+// Static dispatch for shapes: hold them by value (std::variant or one vector per type) instead of Shape*,
+// add a new shape type without touching any switch, and compare the speed with the virtual version.
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include "Shape.h"
+#include "StaticShapes.h"
+
+using namespace std;
+
+// A new shape: just a struct with areaImpl(), then add it to the type list below.
+class Triangle : public static_shapes::StaticShape<Triangle> {
+public:
+    Triangle(double b, double h) : base(b), height(h) {}
+    double areaImpl() const { return 0.5 * base * height; }
+    double base, height;
+};
+
+using MyShapes = static_shapes::TypeList<static_shapes::Circle, static_shapes::Rectangle, Triangle>;
+
+// Runs 'body' a few times and returns the best time in milliseconds.
+template <typename Body>
+double bestOf(int runs, Body body, double &result) {
+    double best = 1e300;
+    for (int r = 0; r < runs; ++r) {
+        auto start = chrono::steady_clock::now();
+        result = body();
+        best = min(best, chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+int main() {
+    const int count = 3000000;
+
+    vector<unique_ptr<Shape>> virtualShapes;
+    static_shapes::ShapeList<MyShapes> variantShapes;
+    static_shapes::ShapeColumns<MyShapes> columnShapes;
+    virtualShapes.reserve(count);
+    variantShapes.reserve(count);
+
+    for (int i = 0; i < count; ++i) {
+        double a = 1.0 + i % 10, b = 2.0 + i % 3;
+        switch (i % 3) {   // only the test data generator needs to know the types
+        case 0:
+            virtualShapes.push_back(make_unique<Circle>(a));
+            variantShapes.add(static_shapes::Circle(a));
+            columnShapes.add(static_shapes::Circle(a));
+            break;
+        case 1:
+            virtualShapes.push_back(make_unique<Rectangle>(a, b));
+            variantShapes.add(static_shapes::Rectangle(a, b));
+            columnShapes.add(static_shapes::Rectangle(a, b));
+            break;
+        default:
+            virtualShapes.push_back(make_unique<Rectangle>(0.5 * a, b));   // same area as Triangle(a, b)
+            variantShapes.add(Triangle(a, b));
+            columnShapes.add(Triangle(a, b));
+            break;
+        }
+    }
+
+    double virtualTotal, variantTotal, columnTotal;
+    double virtualMs = bestOf(5, [&] {
+        double total = 0;
+        for (const auto &shape : virtualShapes) total += shape->area();
+        return total;
+    }, virtualTotal);
+    double variantMs = bestOf(5, [&] { return variantShapes.totalArea(); }, variantTotal);
+    double columnMs = bestOf(5, [&] { return columnShapes.totalArea(); }, columnTotal);
+
+    cout << "virtual Shape*:    " << virtualTotal << "  " << virtualMs << " ms" << endl;
+    cout << "std::variant list: " << variantTotal << "  " << variantMs << " ms" << endl;
+    cout << "per-type columns:  " << columnTotal << "  " << columnMs << " ms" << endl;
+
+    // Visitor API: count the shapes of each type without any dynamic_cast.
+    size_t circles = 0, others = 0;
+    variantShapes.forEach([&](const auto &shape) {
+        if constexpr (is_same_v<decay_t<decltype(shape)>, static_shapes::Circle>) ++circles;
+        else ++others;
+    });
+    cout << circles << " circles, " << others << " other shapes" << endl;
+
+    return 0;
+}
+
+
+/*Virtual vs static dispatch:
+
+1. virtual: vector<unique_ptr<Shape>> -> every element is a pointer to its own heap block, area() is an indirect call
+   through the vtable and cannot be inlined.
+2. std::variant: the shapes are stored by value next to each other. std::visit picks the right area() from the variant
+   index, and each area() is inlined. Adding Triangle only meant adding it to MyShapes.
+3. Per-type columns: every type has its own vector, so the loop for each type has no dispatch at all and the compiler
+   can vectorize it.
+4. CRTP: StaticShape<Derived>::area() calls Derived::areaImpl() through a static_cast, resolved at compile time.*/
@@ -0,0 +1,401 @@
+#ifndef CO_RUNTIME_H
+#define CO_RUNTIME_H
+
+// Single-threaded cooperative runtime on C++20 coroutines: the while(true) { work(); sleep_for(period); }
+// loops of code5_2.cpp become coroutines that all run on one thread, and a loop that waits gives the
+// thread to the next one instead of blocking it.
+//
+//     coro::Runtime rt;
+//     coro::Channel<Reading> readings(rt, 64);
+//     rt.spawn([](coro::Runtime& rt, coro::Channel<Reading>& out) -> coro::Task {
+//         auto next = coro::Runtime::Clock::now();
+//         while (true) {
+//             out.push(readSensor());
+//             co_await rt.sleepUntil(next += std::chrono::seconds(1));   // drift-free period
+//         }
+//     }(rt, readings));
+//     rt.spawn(display(rt, readings));      // Reading r = co_await readings.pop();
+//     rt.spawn(serial(rt, fd));             // co_await rt.readable(fd); then read(fd, ...) does not block
+//     rt.run();                             // until every task has finished or stop() was called
+//
+// - A Task starts suspended and runs when the runtime gets to it. It is destroyed when it returns, or with
+//   the runtime if it is still waiting then. Pass the coroutine what it needs as parameters (copied into its
+//   frame); do not capture in the lambda, the lambda object is gone after the call.
+// - Awaitables: sleep(duration), sleepUntil(time), yield(), readable(fd) / writable(fd) (epoll), and
+//   Channel<T>::pop(). Channel::push() never waits; it returns false when the channel is full.
+// - Frames come from a pool of size classes (64-byte steps up to 1 KB), so creating and ending tasks does
+//   not go to malloc after warm-up, and frameStats() reports what the frames really cost.
+// - Timers are a binary heap of deadlines. When nothing is ready the thread sleeps in epoll_wait until the
+//   next deadline or file descriptor event. epoll_wait counts in milliseconds (rounded up), so a timer
+//   that puts the thread to sleep can fire up to 1 ms late.
+// - Everything runs on the thread that calls run(); nothing here is thread-safe. An exception escaping a
+//   task ends the program (there is nobody to report it to).
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <new>
+#include <optional>
+#include <queue>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace coro {
+
+struct FrameStats {
+    size_t live = 0;          // frames allocated now
+    size_t bytes = 0;         // their total size as requested by the compiler
+    size_t largest = 0;
+    uint64_t allocations = 0;
+    uint64_t fromPool = 0;    // allocations served by a free list
+};
+
+// Frame allocator: free lists per 64-byte size class. Frames of one coroutine function all have the same
+// size, so a finished task's frame is reused by the next task of the same kind.
+class FramePool {
+public:
+    static const size_t kStep = 64;
+    static const size_t kClasses = 16;   // up to 1 KB; larger frames go to operator new
+
+    static void* allocate(size_t n) {
+        FrameStats& s = stats();
+        ++s.allocations;
+        ++s.live;
+        s.bytes += n;
+        if (n > s.largest) s.largest = n;
+        size_t c = (n + kStep - 1) / kStep;
+        if (c > kClasses) return ::operator new(n);
+        FreeBlock*& head = lists()[c - 1];
+        if (head) {
+            ++s.fromPool;
+            FreeBlock* b = head;
+            head = b->next;
+            return b;
+        }
+        return ::operator new(c * kStep);
+    }
+
+    static void release(void* p, size_t n) {
+        FrameStats& s = stats();
+        --s.live;
+        s.bytes -= n;
+        size_t c = (n + kStep - 1) / kStep;
+        if (c > kClasses) {
+            ::operator delete(p);
+            return;
+        }
+        FreeBlock* b = static_cast<FreeBlock*>(p);
+        b->next = lists()[c - 1];
+        lists()[c - 1] = b;
+    }
+
+    static FrameStats& stats() {
+        static thread_local FrameStats s;
+        return s;
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    // The blocks stay in the lists until the thread ends; they are meant to be reused, not returned.
+    struct Lists {
+        FreeBlock* heads[kClasses] = {};
+        ~Lists() {
+            for (FreeBlock*& h : heads) {
+                while (h) {
+                    FreeBlock* next = h->next;
+                    ::operator delete(h);
+                    h = next;
+                }
+            }
+        }
+    };
+
+    static FreeBlock** lists() {
+        static thread_local Lists l;
+        return l.heads;
+    }
+};
+
+inline FrameStats frameStats() { return FramePool::stats(); }
+
+class Task {
+public:
+    struct promise_type {
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }   // the runtime destroys the frame
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+
+        static void* operator new(size_t n) { return FramePool::allocate(n); }
+        static void operator delete(void* p, size_t n) { FramePool::release(p, n); }
+    };
+
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (handle) handle.destroy();
+    }
+
+private:
+    friend class Runtime;
+    explicit Task(std::coroutine_handle<promise_type> h) : handle(h) {}
+    std::coroutine_handle<promise_type> handle;
+};
+
+struct RuntimeStats {
+    uint64_t resumes = 0;
+    uint64_t timersFired = 0;
+    uint64_t ioEvents = 0;
+    uint64_t sleeps = 0;          // times the thread slept in epoll_wait
+    size_t maxReady = 0;          // longest ready queue seen
+    double maxTimerLateUs = 0;    // worst delay between a deadline and the resume
+};
+
+class Runtime {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    Runtime() : epollFd(epoll_create1(EPOLL_CLOEXEC)) {}
+
+    Runtime(const Runtime&) = delete;
+    Runtime& operator=(const Runtime&) = delete;
+
+    ~Runtime() {
+        for (void* address : live) std::coroutine_handle<>::from_address(address).destroy();
+        if (epollFd >= 0) close(epollFd);
+    }
+
+    // Takes the task over; it runs in the next round of run().
+    void spawn(Task task) {
+        std::coroutine_handle<> h = std::exchange(task.handle, nullptr);
+        live.insert(h.address());
+        schedule(h);
+    }
+
+    // Runs until every task has finished, stop() was called, or no task can go on (all of them wait on
+    // channels, with no timer and no descriptor left that could wake one).
+    void run() {
+        stopping = false;
+        std::vector<std::coroutine_handle<>> batch;
+        while (!stopping && !live.empty()) {
+            fireTimers();
+            if (ready.empty()) {
+                waitForEvents();
+                continue;
+            }
+            if (ready.size() > counters.maxReady) counters.maxReady = ready.size();
+            batch.swap(ready);   // tasks made ready while this batch runs wait for the next round
+            for (std::coroutine_handle<> h : batch) {
+                ++counters.resumes;
+                h.resume();
+                if (h.done()) {
+                    live.erase(h.address());
+                    h.destroy();
+                }
+            }
+            batch.clear();
+            pollEvents();   // descriptors that became ready while the batch ran, without sleeping
+        }
+    }
+
+    void stop() { stopping = true; }
+
+    size_t tasks() const { return live.size(); }
+    const RuntimeStats& stats() const { return counters; }
+
+    // ---- awaitables ----
+
+    struct TimerAwaiter {
+        Runtime& rt;
+        Clock::time_point deadline;
+        bool await_ready() const { return deadline <= Clock::now(); }
+        void await_suspend(std::coroutine_handle<> h) { rt.addTimer(deadline, h); }
+        void await_resume() const {}
+    };
+
+    TimerAwaiter sleepUntil(Clock::time_point deadline) { return TimerAwaiter{*this, deadline}; }
+    template <typename Rep, typename Period>
+    TimerAwaiter sleep(std::chrono::duration<Rep, Period> d) {
+        return TimerAwaiter{*this, Clock::now() + std::chrono::duration_cast<Clock::duration>(d)};
+    }
+
+    struct YieldAwaiter {
+        Runtime& rt;
+        bool await_ready() const { return false; }
+        void await_suspend(std::coroutine_handle<> h) { rt.schedule(h); }
+        void await_resume() const {}
+    };
+
+    // Lets the other ready tasks run first.
+    YieldAwaiter yield() { return YieldAwaiter{*this}; }
+
+    struct IoAwaiter {
+        Runtime& rt;
+        int fd;
+        uint32_t events;
+        bool ok = true;
+        bool await_ready() const { return false; }
+        bool await_suspend(std::coroutine_handle<> h) {
+            ok = rt.watch(fd, events, h);
+            return ok;   // could not watch the descriptor: continue at once, await_resume reports it
+        }
+        bool await_resume() const { return ok; }
+    };
+
+    // Resumes the task when fd can be read / written without blocking. co_await returns false when the
+    // descriptor cannot be watched (closed, or a regular file). One waiting task per descriptor.
+    IoAwaiter readable(int fd) { return IoAwaiter{*this, fd, EPOLLIN}; }
+    IoAwaiter writable(int fd) { return IoAwaiter{*this, fd, EPOLLOUT}; }
+
+    // Call before closing a descriptor that was awaited.
+    void forget(int fd) {
+        if (watched.erase(fd)) epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+
+    void schedule(std::coroutine_handle<> h) { ready.push_back(h); }
+
+private:
+    struct Timer {
+        Clock::time_point deadline;
+        uint64_t seq;   // equal deadlines run in the order they were set
+        std::coroutine_handle<> handle;
+        bool operator>(const Timer& o) const { return deadline != o.deadline ? deadline > o.deadline : seq > o.seq; }
+    };
+
+    void addTimer(Clock::time_point deadline, std::coroutine_handle<> h) { timers.push(Timer{deadline, timerSeq++, h}); }
+
+    void fireTimers() {
+        Clock::time_point now = Clock::now();
+        while (!timers.empty() && timers.top().deadline <= now) {
+            double lateUs = std::chrono::duration<double, std::micro>(now - timers.top().deadline).count();
+            if (lateUs > counters.maxTimerLateUs) counters.maxTimerLateUs = lateUs;
+            schedule(timers.top().handle);
+            timers.pop();
+            ++counters.timersFired;
+        }
+    }
+
+    bool watch(int fd, uint32_t events, std::coroutine_handle<> h) {
+        epoll_event ev{};
+        ev.events = events | EPOLLONESHOT;
+        ev.data.ptr = h.address();
+        bool known = watched.count(fd) != 0;
+        if (epoll_ctl(epollFd, known ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &ev) != 0) return false;
+        watched.insert(fd);
+        ++waitingIo;
+        return true;
+    }
+
+    // Sleeps until the next timer or descriptor event.
+    void waitForEvents() {
+        int timeoutMs = -1;
+        if (!timers.empty()) {
+            auto d = timers.top().deadline - Clock::now();
+            if (d <= Clock::duration::zero()) return;
+            timeoutMs = (int)std::chrono::ceil<std::chrono::milliseconds>(d).count();
+        } else if (waitingIo == 0) {
+            stopping = true;   // every task waits on a channel that nobody will push to
+            return;
+        }
+        ++counters.sleeps;
+        collectEvents(timeoutMs);
+    }
+
+    void pollEvents() {
+        if (waitingIo) collectEvents(0);
+    }
+
+    void collectEvents(int timeoutMs) {
+        epoll_event events[64];
+        int n = epoll_wait(epollFd, events, 64, timeoutMs);
+        for (int i = 0; i < n; ++i) {
+            schedule(std::coroutine_handle<>::from_address(events[i].data.ptr));
+            --waitingIo;
+            ++counters.ioEvents;
+        }
+    }
+
+    int epollFd;
+    bool stopping = false;
+    std::vector<std::coroutine_handle<>> ready;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    uint64_t timerSeq = 0;
+    std::unordered_set<void*> live;
+    std::unordered_set<int> watched;
+    size_t waitingIo = 0;
+    RuntimeStats counters;
+};
+
+// Bounded queue between tasks. pop() waits for an item; push() hands the item straight to a waiting task
+// if there is one.
+template <typename T>
+class Channel {
+public:
+    Channel(Runtime& rt, size_t capacity) : rt(rt), capacity(capacity) {}
+
+    Channel(const Channel&) = delete;
+    Channel& operator=(const Channel&) = delete;
+
+    bool push(T value) {
+        if (!waiters.empty()) {
+            PopAwaiter* w = waiters.front();
+            waiters.pop_front();
+            w->value.emplace(std::move(value));
+            rt.schedule(w->handle);
+            return true;
+        }
+        if (items.size() == capacity) {
+            ++droppedCount;
+            return false;
+        }
+        items.push_back(std::move(value));
+        return true;
+    }
+
+    struct PopAwaiter {
+        Channel& ch;
+        std::optional<T> value;
+        std::coroutine_handle<> handle;
+
+        bool await_ready() {
+            if (ch.items.empty()) return false;
+            value.emplace(std::move(ch.items.front()));
+            ch.items.pop_front();
+            return true;
+        }
+        void await_suspend(std::coroutine_handle<> h) {
+            handle = h;
+            ch.waiters.push_back(this);
+        }
+        T await_resume() { return std::move(*value); }
+    };
+
+    PopAwaiter pop() { return PopAwaiter{*this, std::nullopt, nullptr}; }
+
+    size_t size() const { return items.size(); }
+    uint64_t dropped() const { return droppedCount; }
+
+private:
+    Runtime& rt;
+    const size_t capacity;
+    std::deque<T> items;
+    std::deque<PopAwaiter*> waiters;   // the awaiters live in the waiting tasks' frames
+    uint64_t droppedCount = 0;
+};
+
+} // namespace coro
+
+#endif // CO_RUNTIME_H
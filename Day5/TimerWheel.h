@@ -0,0 +1,351 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+// One thread that runs thousands of periodic and one-shot jobs, instead of one thread per
+// while(true) { work(); sleep_for(period); } loop (code5_2.cpp).
+//
+//     TimerWheel wheel;                                               // 1 ms tick
+//     TimerWheel::Id id = wheel.schedulePeriodic(chrono::seconds(1), [] { readSensor(); });
+//     wheel.scheduleOnce(chrono::milliseconds(250), [] { beep(); });
+//     wheel.cancel(id);
+//
+// - Drift-free: the next deadline of a periodic job is the previous *deadline* + period, not "now" + period,
+//   so the time the job itself takes does not add up. If a job falls behind by whole periods, those runs are
+//   skipped (and counted as missed) instead of being run back to back.
+// - Hierarchical wheel: 4 levels of 64 slots. Level 0 holds jobs due in the next 64 ticks, level 1 the next
+//   64*64 ticks, and so on (2^24 ticks = 4.6 hours at 1 ms). Scheduling and cancelling are O(1); when level 0 wraps
+//   around, the next slot of level 1 is spread over level 0 ("cascade"). Later deadlines wait in the last level.
+// - Each level keeps a bitmap of its non-empty slots, so the thread sleeps until the next due slot instead of
+//   waking up every tick.
+// - Callbacks run on the wheel thread, without the lock held: they may schedule or cancel jobs (also themselves).
+//   A slow callback delays the others, so keep them short or hand the work to a queue.
+// - Jitter statistics per job: how late each run started compared with its deadline.
+
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Id = uint64_t;   // 0 is never a valid id
+
+    struct JitterStats {
+        uint64_t runs = 0;
+        uint64_t missed = 0;              // periods skipped because the job was more than one period late
+        Clock::duration minLate = Clock::duration::max();
+        Clock::duration maxLate = Clock::duration::zero();
+        double averageLateUs = 0;
+        double m2LateUs = 0;              // sum of squared deviations from averageLateUs (Welford, as tsdb::Aggregate)
+
+        void addLate(double lateUs) {
+            ++runs;
+            double d = lateUs - averageLateUs;
+            averageLateUs += d / runs;
+            m2LateUs += d * (lateUs - averageLateUs);
+        }
+
+        double meanLateUs() const { return runs ? averageLateUs : 0; }
+        double stddevLateUs() const {
+            if (runs < 2) return 0;
+            return std::sqrt(std::max(0.0, m2LateUs / runs));
+        }
+    };
+
+    explicit TimerWheel(Clock::duration tick = std::chrono::milliseconds(1))
+        : tick(tick), origin(Clock::now()) {
+        for (auto& level : heads) {
+            for (auto& head : level) head = kNone;
+        }
+        worker = std::thread(&TimerWheel::run, this);
+    }
+
+    ~TimerWheel() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stop = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // Runs 'callback' every 'period', the first time after 'firstDelay' (default: one period).
+    Id schedulePeriodic(Clock::duration period, std::function<void()> callback,
+                        Clock::duration firstDelay = Clock::duration::min()) {
+        if (firstDelay == Clock::duration::min()) firstDelay = period;
+        return add(Clock::now() + firstDelay, period, std::move(callback));
+    }
+
+    Id scheduleOnce(Clock::duration delay, std::function<void()> callback) {
+        return add(Clock::now() + delay, Clock::duration::zero(), std::move(callback));
+    }
+
+    Id scheduleAt(Clock::time_point deadline, std::function<void()> callback) {
+        return add(deadline, Clock::duration::zero(), std::move(callback));
+    }
+
+    // Returns false if the job does not exist (any more). A job that is running right now finishes its run.
+    bool cancel(Id id) {
+        std::lock_guard<std::mutex> lock(mtx);
+        Timer* t = find(id);
+        if (!t || t->cancelled) return false;
+        if (t->state == State::Running) {
+            t->cancelled = true;   // the wheel thread frees it after the callback returns
+        } else {
+            unlink(indexOf(id));
+            release(indexOf(id));
+        }
+        return true;
+    }
+
+    // Copies the statistics of a job that is still scheduled; false if it is gone.
+    bool stats(Id id, JitterStats& out) {
+        std::lock_guard<std::mutex> lock(mtx);
+        Timer* t = find(id);
+        if (!t) return false;
+        out = t->stats;
+        return true;
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return active;
+    }
+
+private:
+    static const int kLevels = 4;
+    static const int kBits = 6;
+    static const int kSlots = 1 << kBits;
+    static const uint64_t kMask = kSlots - 1;
+    static const uint32_t kNone = UINT32_MAX;
+
+    enum class State : uint8_t { Free, Pending, Running };
+
+    struct Timer {
+        std::function<void()> callback;
+        Clock::time_point deadline;
+        Clock::duration period;      // zero for one-shot jobs
+        uint64_t deadlineTick = 0;
+        uint32_t prev = kNone, next = kNone;
+        uint32_t generation = 0;     // part of the Id, so a stale Id never matches a reused slot
+        uint8_t level = 0, slot = 0;
+        State state = State::Free;
+        bool cancelled = false;
+        JitterStats stats;
+    };
+
+    static uint32_t indexOf(Id id) { return (uint32_t)id; }
+
+    Timer* find(Id id) {
+        uint32_t i = indexOf(id);
+        if (i >= timers.size()) return nullptr;
+        Timer& t = timers[i];
+        if (t.state == State::Free || t.generation != (uint32_t)(id >> 32)) return nullptr;
+        return &t;
+    }
+
+    // First tick at or after 'when' (jobs never run early).
+    uint64_t tickOf(Clock::time_point when) const {
+        if (when <= origin) return 0;
+        return (uint64_t)((when - origin + tick - Clock::duration(1)) / tick);
+    }
+
+    uint64_t elapsedTicks(Clock::time_point now) const { return (uint64_t)((now - origin) / tick); }
+
+    Id add(Clock::time_point deadline, Clock::duration period, std::function<void()> callback) {
+        std::lock_guard<std::mutex> lock(mtx);
+        uint32_t i;
+        if (!freeList.empty()) {
+            i = freeList.back();
+            freeList.pop_back();
+        } else {
+            i = (uint32_t)timers.size();
+            timers.emplace_back();
+        }
+        Timer& t = timers[i];
+        t.callback = std::move(callback);
+        t.deadline = deadline;
+        t.period = period;
+        t.deadlineTick = tickOf(deadline);
+        t.state = State::Pending;
+        t.cancelled = false;
+        t.stats = JitterStats();
+        ++active;
+        insert(i);
+        if (t.deadlineTick < sleepingUntil) {
+            wake.notify_one();   // the thread sleeps past this deadline
+        }
+        return ((Id)t.generation << 32) | i;
+    }
+
+    void release(uint32_t i) {
+        Timer& t = timers[i];
+        t.callback = nullptr;
+        t.state = State::Free;
+        ++t.generation;
+        freeList.push_back(i);
+        --active;
+    }
+
+    // Puts a timer into the slot that matches its distance from the current tick.
+    void insert(uint32_t i) {
+        Timer& t = timers[i];
+        uint64_t due = t.deadlineTick < currentTick ? currentTick : t.deadlineTick;
+        uint64_t delta = due - currentTick;
+        int level = 0;
+        while (level < kLevels - 1 && delta >= (1ull << (kBits * (level + 1)))) ++level;
+        if (delta >= (1ull << (kBits * kLevels))) {
+            due = currentTick + (1ull << (kBits * kLevels)) - 1;   // re-sorted by its real deadline when cascaded
+        }
+        t.level = (uint8_t)level;
+        t.slot = (uint8_t)((due >> (kBits * level)) & kMask);
+
+        uint32_t& head = heads[level][t.slot];
+        t.prev = kNone;
+        t.next = head;
+        if (head != kNone) timers[head].prev = i;
+        head = i;
+        occupied[level] |= 1ull << t.slot;
+    }
+
+    void unlink(uint32_t i) {
+        Timer& t = timers[i];
+        if (t.prev != kNone) timers[t.prev].next = t.next;
+        else heads[t.level][t.slot] = t.next;
+        if (t.next != kNone) timers[t.next].prev = t.prev;
+        if (heads[t.level][t.slot] == kNone) occupied[t.level] &= ~(1ull << t.slot);
+    }
+
+    // Detaches a whole slot and returns its first timer (the rest follow through 'next').
+    uint32_t takeSlot(int level, unsigned slot) {
+        uint32_t first = heads[level][slot];
+        heads[level][slot] = kNone;
+        occupied[level] &= ~(1ull << slot);
+        return first;
+    }
+
+    // Called when level 0 wraps around: spread the next slot of each higher level over the levels below.
+    void cascade() {
+        for (int level = 1; level < kLevels; ++level) {
+            unsigned slot = (unsigned)((currentTick >> (kBits * level)) & kMask);
+            for (uint32_t i = takeSlot(level, slot); i != kNone;) {
+                uint32_t next = timers[i].next;
+                insert(i);
+                i = next;
+            }
+            if (slot != 0) break;   // the level above only turns over when this one wraps too
+        }
+    }
+
+    // Next tick that needs work: a non-empty level 0 slot in this round, or the next wrap-around (cascade).
+    uint64_t nextInterestingTick() const {
+        unsigned pos = (unsigned)(currentTick & kMask);
+        if (pos == 0) return currentTick;
+        uint64_t bits = occupied[0] & (~0ull << pos);
+        if (bits) return (currentTick & ~kMask) + (uint64_t)__builtin_ctzll(bits);
+        return (currentTick | kMask) + 1;
+    }
+
+    // Processes every tick up to and including 'nowTick' and collects the timers that are due.
+    void advance(uint64_t nowTick, std::vector<uint32_t>& due) {
+        while (currentTick <= nowTick) {
+            if ((currentTick & kMask) == 0) cascade();
+            unsigned slot = (unsigned)(currentTick & kMask);
+            for (uint32_t i = takeSlot(0, slot); i != kNone; i = timers[i].next) {
+                timers[i].state = State::Running;
+                due.push_back(i);
+            }
+            ++currentTick;
+            uint64_t next = nextInterestingTick();   // skip empty slots
+            currentTick = next < nowTick + 1 ? next : nowTick + 1;
+        }
+    }
+
+    void finishRun(uint32_t i, Clock::time_point now) {
+        Timer& t = timers[i];
+        if (t.cancelled || t.period == Clock::duration::zero()) {
+            release(i);
+            return;
+        }
+        t.deadline += t.period;   // absolute deadlines: no drift
+        if (t.deadline <= now) {
+            uint64_t behind = (uint64_t)((now - t.deadline) / t.period) + 1;
+            t.deadline += t.period * (Clock::rep)behind;
+            t.stats.missed += behind;
+        }
+        t.deadlineTick = tickOf(t.deadline);
+        t.state = State::Pending;
+        insert(i);
+    }
+
+    void run() {
+        std::vector<uint32_t> due;
+        std::unique_lock<std::mutex> lock(mtx);
+        while (!stop) {
+            advance(elapsedTicks(Clock::now()), due);
+
+            for (uint32_t i : due) {
+                Timer& t = timers[i];
+                if (t.cancelled) {   // cancelled by an earlier callback of this batch
+                    release(i);
+                    continue;
+                }
+                Clock::time_point deadline = t.deadline;
+                std::function<void()> callback = std::move(t.callback);   // 'timers' may grow while unlocked
+                lock.unlock();
+
+                Clock::time_point start = Clock::now();
+                callback();
+
+                lock.lock();
+                Timer& done = timers[i];
+                done.callback = std::move(callback);
+                JitterStats& s = done.stats;
+                Clock::duration late = start - deadline;
+                double lateUs = std::chrono::duration<double, std::micro>(late).count();
+                s.addLate(lateUs);
+                if (late < s.minLate) s.minLate = late;
+                if (late > s.maxLate) s.maxLate = late;
+                finishRun(i, Clock::now());
+            }
+            due.clear();
+
+            // Sleep until the next tick that has work (or until a job with an earlier deadline is added).
+            if (active == 0) {
+                sleepingUntil = UINT64_MAX;
+                wake.wait(lock);
+            } else {
+                sleepingUntil = nextInterestingTick();
+                wake.wait_until(lock, origin + tick * (Clock::rep)sleepingUntil);
+            }
+            sleepingUntil = 0;
+        }
+    }
+
+    const Clock::duration tick;
+    const Clock::time_point origin;
+
+    std::vector<Timer> timers;       // slab; an Id is (generation << 32) | index
+    std::vector<uint32_t> freeList;
+    size_t active = 0;
+    uint32_t heads[kLevels][kSlots];
+    uint64_t occupied[kLevels] = {};   // bit s set: slot s of that level is not empty
+    uint64_t currentTick = 0;          // next tick to process
+    uint64_t sleepingUntil = 0;        // tick the thread sleeps until (0 while it is awake)
+
+    std::mutex mtx;
+    std::condition_variable wake;
+    bool stop = false;
+    std::thread worker;
+};
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,267 @@
+// code5_2.cpp on the coroutine runtime (CoRuntime.h): Sensor and Display become coroutines on one thread.
+// Then a gateway with 5000 simulated devices, each a coroutine with its own period that sends readings
+// through a channel to an aggregator, plus 50 serial ports (pipes) served by coroutines that wait for the
+// descriptor to become readable, all on one thread for two seconds.
+// Last, what threads would cost instead: memory per waiting thread and per waiting coroutine (resident
+// set growth) and a ping-pong between two threads against one between two coroutines.
+//     g++ -std=c++20 -O2 -pthread code5_4.cpp -o code5_4
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <semaphore.h>
+#include <sys/resource.h>
+#include "CoRuntime.h"
+
+using namespace std;
+using Clock = coro::Runtime::Clock;
+
+// ---- code5_2.cpp ----
+
+class Sensor {
+public:
+    coro::Task readSensorData(coro::Runtime& rt, coro::Channel<int>& out, chrono::milliseconds period) {
+        Clock::time_point next = Clock::now();
+        for (int reading = 0;; ++reading) {
+            std::cout << "Reading sensor data" << std::endl;
+            out.push(reading);
+            co_await rt.sleepUntil(next += period);
+        }
+    }
+};
+
+class Display {
+public:
+    coro::Task updateDisplay(coro::Runtime& rt, coro::Channel<int>& in, chrono::milliseconds period) {
+        Clock::time_point next = Clock::now();
+        while (true) {
+            int latest = co_await in.pop();   // wait for at least one reading
+            while (in.size()) latest = co_await in.pop();
+            std::cout << "Updating display (reading " << latest << ")" << std::endl;
+            co_await rt.sleepUntil(next += period);
+        }
+    }
+};
+
+coro::Task stopAfter(coro::Runtime& rt, chrono::milliseconds d) {
+    co_await rt.sleep(d);
+    rt.stop();
+}
+
+// ---- the gateway ----
+
+struct Reading {
+    uint32_t device;
+    uint32_t value;
+};
+
+coro::Task device(coro::Runtime& rt, coro::Channel<Reading>& out, uint32_t id, chrono::milliseconds period) {
+    Clock::time_point next = Clock::now() + chrono::microseconds(id * 7 % period.count() * 1000);   // spread the phases
+    for (uint32_t n = 0;; ++n) {
+        co_await rt.sleepUntil(next);
+        out.push(Reading{id, n});
+        next += period;
+    }
+}
+
+coro::Task aggregator(coro::Channel<Reading>& in, uint64_t& readings, uint64_t& sum) {
+    while (true) {
+        Reading r = co_await in.pop();
+        ++readings;
+        sum += r.value;
+    }
+}
+
+coro::Task serialPort(coro::Runtime& rt, int fd, uint64_t& bytes) {
+    char buf[256];
+    while (co_await rt.readable(fd)) {
+        ssize_t n = read(fd, buf, sizeof buf);   // does not block: the descriptor is readable
+        if (n <= 0) break;
+        bytes += n;
+    }
+}
+
+coro::Task lineTraffic(coro::Runtime& rt, vector<int> fds, uint64_t& written) {   // the far ends of the lines
+    const char message[] = "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47\r\n";
+    minstd_rand rng(5);   // mt19937 would put 5 KB of state into the frame
+    while (true) {
+        co_await rt.sleep(chrono::milliseconds(1));
+        for (int i = 0; i < 10; ++i) {
+            if (write(fds[rng() % fds.size()], message, sizeof message - 1) > 0) written += sizeof message - 1;
+        }
+    }
+}
+
+// ---- cost of threads ----
+
+size_t residentBytes() {
+    long pages = 0, resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (f) {
+        if (fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+        fclose(f);
+    }
+    return (size_t)resident * sysconf(_SC_PAGESIZE);
+}
+
+double cpuSeconds() {
+    rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+coro::Task idle(coro::Runtime& rt) { co_await rt.sleep(chrono::hours(1)); }
+
+coro::Task pingPong(coro::Channel<int>& in, coro::Channel<int>& out, int rounds, bool serve) {
+    if (!serve) out.push(0);
+    for (int i = 0; i < rounds; ++i) {
+        int v = co_await in.pop();
+        if (serve || i + 1 < rounds) out.push(v + 1);
+    }
+}
+
+int main() {
+    // ---- Part 1: code5_2.cpp, periods scaled down from 1 s and 2 s ----
+    {
+        coro::Runtime rt;
+        coro::Channel<int> readings(rt, 16);
+        Sensor sensor;
+        Display display;
+        rt.spawn(sensor.readSensorData(rt, readings, chrono::milliseconds(100)));
+        rt.spawn(display.updateDisplay(rt, readings, chrono::milliseconds(200)));
+        rt.spawn(stopAfter(rt, chrono::milliseconds(450)));
+        rt.run();
+    }
+
+    // ---- Part 2: the gateway ----
+    const uint32_t kDevices = 5000;
+    const int kPorts = 50;
+    coro::Runtime rt;
+    coro::Channel<Reading> readings(rt, 4096);
+    uint64_t count = 0, sum = 0, serialBytes = 0, written = 0;
+    double expected = 0;
+    mt19937 rng(5);
+    size_t before = residentBytes();
+    for (uint32_t id = 0; id < kDevices; ++id) {
+        chrono::milliseconds period(20 + rng() % 81);
+        expected += 2000.0 / period.count();
+        rt.spawn(device(rt, readings, id, period));
+    }
+    rt.spawn(aggregator(readings, count, sum));
+    vector<int> readEnds, writeEnds;
+    for (int i = 0; i < kPorts; ++i) {
+        int p[2];
+        if (pipe2(p, O_NONBLOCK | O_CLOEXEC) != 0) return 1;
+        readEnds.push_back(p[0]);
+        writeEnds.push_back(p[1]);
+        rt.spawn(serialPort(rt, p[0], serialBytes));
+    }
+    rt.spawn(lineTraffic(rt, writeEnds, written));
+    rt.spawn(stopAfter(rt, chrono::milliseconds(2000)));
+    coro::FrameStats frames = coro::frameStats();
+    size_t tasks = rt.tasks();
+
+    double cpu = cpuSeconds();
+    auto start = Clock::now();
+    rt.run();
+    double wall = chrono::duration<double>(Clock::now() - start).count();
+    cpu = cpuSeconds() - cpu;
+    size_t grown = residentBytes() - before;
+
+    const coro::RuntimeStats& st = rt.stats();
+    cout << fixed << setprecision(1);
+    cout << tasks << " coroutines on one thread for " << wall << " s (" << kDevices << " devices, " << kPorts
+         << " serial ports, aggregator, line traffic)" << endl;
+    cout << "  frames: " << frames.bytes << " bytes in total, " << frames.bytes / frames.live << " bytes on average, largest "
+         << frames.largest << "; resident set grew by " << grown / 1024 << " KB" << endl;
+    cout << "  " << count << " readings (" << setprecision(0) << expected << " expected), " << readings.dropped()
+         << " dropped" << endl;
+    cout << "  " << st.resumes << " resumes, " << st.timersFired << " timers, " << st.ioEvents << " I/O events, "
+         << st.sleeps << " sleeps; worst timer lateness " << setprecision(2) << st.maxTimerLateUs / 1000
+         << " ms; CPU " << setprecision(1) << 100 * cpu / wall << "% of one core" << endl;
+    char rest[4096];
+    for (int fd : readEnds) {   // what was still in the pipes when the run stopped
+        ssize_t n;
+        while ((n = read(fd, rest, sizeof rest)) > 0) serialBytes += n;
+        rt.forget(fd);
+        close(fd);
+    }
+    for (int fd : writeEnds) close(fd);
+    cout << "  serial ports: " << serialBytes << " of " << written << " bytes received" << endl;
+
+    // ---- Part 3: what a thread per activity would cost ----
+    const int kThreads = 1000;
+    sem_t gate;
+    sem_init(&gate, 0, 0);
+    before = residentBytes();
+    vector<thread> sleepers;
+    for (int i = 0; i < kThreads; ++i) sleepers.emplace_back([&] { sem_wait(&gate); });
+    size_t perThread = (residentBytes() - before) / kThreads;
+    for (int i = 0; i < kThreads; ++i) sem_post(&gate);
+    for (thread& t : sleepers) t.join();
+
+    const int kIdle = 100000;
+    size_t perCoroutine;
+    {
+        coro::Runtime idleRt;
+        before = residentBytes();
+        for (int i = 0; i < kIdle; ++i) idleRt.spawn(idle(idleRt));
+        perCoroutine = (residentBytes() - before) / kIdle;
+    }
+    cout << "Waiting activity: thread " << perThread << " bytes resident (plus " << 8 << " MB of reserved stack), "
+         << "coroutine " << perCoroutine << " bytes (" << kIdle << " measured)" << endl;
+
+    const int kRounds = 200000;
+    sem_t ping, pong;
+    sem_init(&ping, 0, 0);
+    sem_init(&pong, 0, 0);
+    start = Clock::now();
+    thread server([&] {
+        for (int i = 0; i < kRounds; ++i) {
+            sem_wait(&ping);
+            sem_post(&pong);
+        }
+    });
+    for (int i = 0; i < kRounds; ++i) {
+        sem_post(&ping);
+        sem_wait(&pong);
+    }
+    server.join();
+    double threadNs = chrono::duration<double, nano>(Clock::now() - start).count() / kRounds;
+
+    coro::Runtime pp;
+    coro::Channel<int> a(pp, 1), b(pp, 1);
+    pp.spawn(pingPong(a, b, kRounds, true));
+    pp.spawn(pingPong(b, a, kRounds, false));
+    start = Clock::now();
+    pp.run();
+    double coroNs = chrono::duration<double, nano>(Clock::now() - start).count() / kRounds;
+    cout << "Ping-pong round trip: threads " << setprecision(0) << threadNs << " ns, coroutines " << coroNs << " ns ("
+         << threadNs / coroNs << "x)" << endl;
+
+    return count > 0.95 * expected && readings.dropped() == 0 && serialBytes == written && pp.tasks() == 0 ? 0 : 1;
+}
+
+
+/*Thread per activity vs coroutines on one thread:
+
+1. Memory: a thread needs a stack (8 MB reserved, at least a few pages resident) and kernel structures; a
+   waiting coroutine is its frame, the locals that live across co_await plus a few pointers, a few
+   hundred bytes. The frame sizes are printed above; 5000 devices fit in about a megabyte.
+2. Switching: resuming a coroutine is an indirect call; switching threads goes through the kernel
+   scheduler and reloads registers and stack. The ping-pong shows the difference for one round trip.
+3. Waiting: a device that sleeps is an entry in the timer heap, a port that waits for data is registered
+   with epoll, a consumer that waits for a reading sits in the channel's waiter list. When nothing is
+   ready the one thread sleeps in epoll_wait until the next deadline or descriptor event.
+4. Cooperative: a coroutine runs until its next co_await. A loop that computes for long without awaiting
+   (or calls a blocking function) stops all the others, so long work must yield() now and then, and I/O
+   must use non-blocking descriptors.
+5. Periods are drift-free when the loop sleeps until the previous deadline + period (sleepUntil), as with
+   the timer wheel in code5_3.cpp.
+*/
@@ -0,0 +1,283 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+// Minimal microbenchmark harness (no external library).
+//
+//     bench::Suite suite("embedded-course", argc, argv);
+//     suite.throughput("findMax<int>", "items/s", kItems, [&] { ...one run over kItems items... });
+//     suite.latency("SafeQueue 1P/1C latency", latenciesNs);   // already collected samples, e.g. per item
+//     return suite.finish();
+//
+// Every benchmark is run a few times without measuring (warm-up: caches, page faults, CPU frequency), then
+// 'runs' times with measuring. Each printed line has the median with its 95% confidence interval and a "tail"
+// value: the p99 when there are at least kTailSamples samples (latencies collected per item), otherwise the
+// worst sample (a throughput over 30 runs, where a p99 would just be the slowest run anyway).
+// The intervals come from order statistics, so they make no assumption about the distribution:
+// for a quantile q of n sorted samples the interval is between ranks n*q -/+ 1.96*sqrt(n*q*(1-q)).
+// The --json output also has the p99 and its interval for every benchmark; with few samples that interval
+// simply reaches the largest sample, so use more runs for a tighter one.
+//
+// Command line (handled by Suite):
+//     --runs N          measured runs per benchmark (default 30)
+//     --warmup N        unmeasured runs per benchmark (default 3)
+//     --filter TEXT     only benchmarks whose name contains TEXT
+//     --json FILE       write all results as JSON (one result per line)
+//     --compare FILE    compare with an earlier --json file: a median that got worse and whose confidence
+//                       interval does not overlap the old one is reported as a regression (exit code 2)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bench {
+
+// Keeps the compiler from removing a computation whose result is otherwise unused.
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Stats {
+    size_t samples = 0;
+    double min = 0, max = 0, mean = 0, stddev = 0;
+    double median = 0, medianLow = 0, medianHigh = 0;
+    double p99 = 0, p99Low = 0, p99High = 0;
+};
+
+// Value at quantile q (nearest rank) and its 95% confidence interval. 'sorted' must not be empty.
+inline void quantile(const std::vector<double>& sorted, double q, double& value, double& low, double& high) {
+    const double n = (double)sorted.size();
+    const double z = 1.96;
+    auto at = [&](double rank) {
+        long i = (long)rank;
+        if (i < 0) i = 0;
+        if (i > (long)sorted.size() - 1) i = (long)sorted.size() - 1;
+        return sorted[(size_t)i];
+    };
+    double spread = z * std::sqrt(n * q * (1 - q));
+    value = at(std::ceil(n * q) - 1);
+    low = at(std::floor(n * q - spread) - 1);
+    high = at(std::ceil(n * q + spread) - 1);
+}
+
+// For rates (higher is better) the slow tail is at the bottom, so "p99" is the value 99% of the runs reach or beat.
+inline Stats summarize(std::vector<double> samples, bool higherIsBetter) {
+    Stats s;
+    if (samples.empty()) return s;
+    std::sort(samples.begin(), samples.end());
+    s.samples = samples.size();
+    s.min = samples.front();
+    s.max = samples.back();
+    double sum = 0;
+    for (double v : samples) sum += v;
+    s.mean = sum / samples.size();
+    double squares = 0;
+    for (double v : samples) squares += (v - s.mean) * (v - s.mean);
+    s.stddev = samples.size() > 1 ? std::sqrt(squares / (samples.size() - 1)) : 0;
+    quantile(samples, 0.5, s.median, s.medianLow, s.medianHigh);
+    quantile(samples, higherIsBetter ? 0.01 : 0.99, s.p99, s.p99Low, s.p99High);
+    return s;
+}
+
+struct Result {
+    std::string name;
+    std::string unit;
+    bool higherIsBetter;
+    Stats stats;
+};
+
+class Suite {
+public:
+    static const size_t kTailSamples = 100;   // below this, the tail column shows the worst sample
+
+    Suite(const std::string& name, int argc, char** argv) : suiteName(name) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--runs" && hasValue) runs = std::max(1, std::atoi(argv[++i]));
+            else if (arg == "--warmup" && hasValue) warmup = std::max(0, std::atoi(argv[++i]));
+            else if (arg == "--filter" && hasValue) filter = argv[++i];
+            else if (arg == "--json" && hasValue) jsonFile = argv[++i];
+            else if (arg == "--compare" && hasValue) compareFile = argv[++i];
+            else std::cerr << "bench: ignoring unknown argument " << arg << std::endl;
+        }
+        std::cout << suiteName << ": " << warmup << " warm-up + " << runs << " measured runs per benchmark\n\n"
+                  << std::left << std::setw(44) << "benchmark" << std::right << std::setw(14) << "median"
+                  << std::setw(28) << "95% CI" << std::setw(20) << "tail" << "  unit\n";
+    }
+
+    bool enabled(const std::string& name) const {
+        return filter.empty() || name.find(filter) != std::string::npos;
+    }
+
+    // Times 'body' once per run and records items per second (body processes 'items' items per call).
+    void throughput(const std::string& name, const std::string& unit, double items, const std::function<void()>& body) {
+        measure(name, unit, true, body, [items](double seconds) { return items / seconds; });
+    }
+
+    // Times 'body' once per run and records nanoseconds per item.
+    void timePerItem(const std::string& name, double items, const std::function<void()>& body) {
+        measure(name, "ns/item", false, body, [items](double seconds) { return seconds * 1e9 / items; });
+    }
+
+    // Records samples that were collected by the benchmark itself (for example one latency per queue item).
+    void latency(const std::string& name, const std::vector<double>& nanoseconds) {
+        if (!enabled(name)) return;
+        add(Result{name, "ns", false, summarize(nanoseconds, false)});
+    }
+
+    // Prints the comparison, writes the JSON file; returns the exit code for main().
+    int finish() {
+        if (!jsonFile.empty()) {
+            if (writeJson(jsonFile)) std::cout << "\nResults written to " << jsonFile << "\n";
+            else std::cerr << "bench: cannot write " << jsonFile << std::endl;
+        }
+        if (!compareFile.empty()) {
+            return compare(compareFile) ? 0 : 2;
+        }
+        return 0;
+    }
+
+private:
+    void measure(const std::string& name, const std::string& unit, bool higherIsBetter,
+                 const std::function<void()>& body, const std::function<double(double)>& toSample) {
+        if (!enabled(name)) return;
+        for (int i = 0; i < warmup; ++i) body();
+        std::vector<double> samples;
+        samples.reserve(runs);
+        for (int i = 0; i < runs; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            body();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            samples.push_back(toSample(seconds));
+        }
+        add(Result{name, unit, higherIsBetter, summarize(samples, higherIsBetter)});
+    }
+
+    void add(const Result& r) {
+        std::ostringstream ci;
+        ci << std::setprecision(4) << "[" << r.stats.medianLow << ", " << r.stats.medianHigh << "]";
+        std::ostringstream tail;
+        if (r.stats.samples >= kTailSamples) tail << std::setprecision(4) << "p99 " << r.stats.p99;
+        else tail << std::setprecision(4) << "worst " << (r.higherIsBetter ? r.stats.min : r.stats.max);
+        std::cout << std::left << std::setw(44) << r.name << std::right << std::setprecision(4)
+                  << std::setw(14) << r.stats.median << std::setw(28) << ci.str()
+                  << std::setw(20) << tail.str() << "  " << r.unit << std::endl;
+        results.push_back(r);
+    }
+
+    static void writeString(std::ostream& out, const std::string& s) {
+        out << '"';
+        for (char c : s) {
+            if (c == '"' || c == '\\') out << '\\';
+            out << c;
+        }
+        out << '"';
+    }
+
+    bool writeJson(const std::string& filename) const {
+        std::ofstream out(filename);
+        if (!out) return false;
+        out << std::setprecision(10);
+        out << "{\"suite\":";
+        writeString(out, suiteName);
+        out << ",\"timestamp\":" << (long long)std::time(nullptr)
+            << ",\"hardwareConcurrency\":" << std::thread::hardware_concurrency()
+            << ",\"runs\":" << runs << ",\"warmup\":" << warmup << ",\"results\":[\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            const Stats& s = r.stats;
+            out << "{\"name\":";
+            writeString(out, r.name);
+            out << ",\"unit\":";
+            writeString(out, r.unit);
+            out << ",\"higherIsBetter\":" << (r.higherIsBetter ? "true" : "false")
+                << ",\"samples\":" << s.samples << ",\"min\":" << s.min << ",\"max\":" << s.max
+                << ",\"mean\":" << s.mean << ",\"stddev\":" << s.stddev
+                << ",\"median\":" << s.median << ",\"medianLow\":" << s.medianLow << ",\"medianHigh\":" << s.medianHigh
+                << ",\"p99\":" << s.p99 << ",\"p99Low\":" << s.p99Low << ",\"p99High\":" << s.p99High << "}"
+                << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        out << "]}\n";
+        return (bool)out;
+    }
+
+    // Reads a number field from one result line of our own JSON output.
+    static bool field(const std::string& line, const std::string& key, double& value) {
+        size_t pos = line.find("\"" + key + "\":");
+        if (pos == std::string::npos) return false;
+        value = std::strtod(line.c_str() + pos + key.size() + 3, nullptr);
+        return true;
+    }
+
+    static bool nameOf(const std::string& line, std::string& name) {
+        size_t start = line.find("{\"name\":\"");
+        if (start == std::string::npos) return false;
+        start += 9;
+        name.clear();
+        for (size_t i = start; i < line.size() && line[i] != '"'; ++i) {
+            if (line[i] == '\\' && i + 1 < line.size()) ++i;
+            name += line[i];
+        }
+        return true;
+    }
+
+    bool compare(const std::string& filename) const {
+        std::ifstream in(filename);
+        if (!in) {
+            std::cerr << "bench: cannot read " << filename << std::endl;
+            return false;
+        }
+        struct Old { double median, low, high; };
+        std::map<std::string, Old> old;
+        std::string line, name;
+        while (std::getline(in, line)) {
+            Old o;
+            if (nameOf(line, name) && field(line, "median", o.median) && field(line, "medianLow", o.low) &&
+                field(line, "medianHigh", o.high)) {
+                old[name] = o;
+            }
+        }
+
+        std::cout << "\nCompared with " << filename << ":\n";
+        bool ok = true;
+        for (const Result& r : results) {
+            auto it = old.find(r.name);
+            if (it == old.end()) continue;
+            const Old& o = it->second;
+            const Stats& s = r.stats;
+            double change = o.median != 0 ? (s.median - o.median) / o.median * 100 : 0;
+            bool worse = r.higherIsBetter ? s.medianHigh < o.low : s.medianLow > o.high;
+            bool better = r.higherIsBetter ? s.medianLow > o.high : s.medianHigh < o.low;
+            std::cout << std::left << std::setw(44) << r.name << std::right << std::showpos << std::fixed
+                      << std::setprecision(1) << std::setw(9) << change << "%" << std::noshowpos
+                      << std::defaultfloat << (worse ? "  REGRESSION" : better ? "  improved" : "") << "\n";
+            ok = ok && !worse;
+        }
+        return ok;
+    }
+
+    std::string suiteName;
+    int runs = 30;
+    int warmup = 3;
+    std::string filter;
+    std::string jsonFile;
+    std::string compareFile;
+    std::vector<Result> results;
+};
+
+} // namespace bench
+
+#endif // BENCH_H
@@ -0,0 +1,254 @@
+#ifndef BOUNDED_SAFE_QUEUE_H
+#define BOUNDED_SAFE_QUEUE_H
+
+// Fixed-capacity, lock-free multi-producer / multi-consumer variant of SafeQueue (Day6/challeng6_2.cpp).
+// It is a ring buffer where every slot carries its own sequence number (Dmitry Vyukov's bounded MPMC queue):
+// producers and consumers claim slots with a single CAS on their own index, so there is no shared lock.
+// The mutex and condition variables below are only used on the slow path, when a thread has spun for a
+// while and has to go to sleep because the queue is empty (consumers) or full (producers).
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+template <typename T>
+class BoundedSafeQueue {
+public:
+    // capacity is rounded up to a power of two so that "pos % capacity" becomes "pos & mask".
+    explicit BoundedSafeQueue(size_t capacity) : cells(roundUp(capacity)), mask(cells.size() - 1) {
+        for (size_t i = 0; i < cells.size(); ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedSafeQueue(const BoundedSafeQueue&) = delete;
+    BoundedSafeQueue& operator=(const BoundedSafeQueue&) = delete;
+
+    size_t capacity() const { return cells.size(); }
+
+    // Same API as SafeQueue: push blocks while the queue is full, pop blocks while it is empty.
+    void push(T value) {
+        for (int spin = 0; spin < kSpinCount; ++spin) {
+            if (try_push(std::move(value))) return;
+            cpuRelax();
+        }
+        waitUntil(producersWaiting, notFull, [&] { return tryPushNoWake(std::move(value)); });
+        wake(consumersWaiting, notEmpty);
+    }
+
+    bool pop(T &value) {
+        for (int spin = 0; spin < kSpinCount; ++spin) {
+            if (try_pop(value)) return true;
+            cpuRelax();
+        }
+        waitUntil(consumersWaiting, notEmpty, [&] { return tryPopNoWake(value); });
+        wake(producersWaiting, notFull);
+        return true;
+    }
+
+    // Non-blocking versions: return false instead of waiting. try_push only moves from 'value' when it succeeds.
+    template <typename U>
+    bool try_push(U &&value) {
+        if (!tryPushNoWake(std::forward<U>(value))) return false;
+        wake(consumersWaiting, notEmpty);
+        return true;
+    }
+
+    bool try_pop(T &value) {
+        if (!tryPopNoWake(value)) return false;
+        wake(producersWaiting, notFull);
+        return true;
+    }
+
+    // Pushes all 'count' items, claiming as many consecutive slots as possible with one CAS.
+    // Blocks while the queue is full, like push().
+    void push_batch(T* items, size_t count) {
+        size_t done = 0;
+        int spin = 0;
+        while (done < count) {
+            size_t n = tryPushSome(items + done, count - done);
+            done += n;
+            if (n != 0) { spin = 0; continue; }
+            if (++spin < kSpinCount) { cpuRelax(); continue; }
+            waitUntil(producersWaiting, notFull, [&] {
+                size_t m = pushSomeNoWake(items + done, count - done);
+                done += m;
+                return m != 0;
+            });
+            wake(consumersWaiting, notEmpty);
+            spin = 0;
+        }
+    }
+
+    // Pops up to maxCount items into 'out'. Blocks until at least one item is available and returns how many were popped.
+    size_t pop_batch(T* out, size_t maxCount) {
+        if (maxCount == 0) return 0;
+        for (int spin = 0; spin < kSpinCount; ++spin) {
+            size_t n = tryPopSome(out, maxCount);
+            if (n != 0) return n;
+            cpuRelax();
+        }
+        size_t n = 0;
+        waitUntil(consumersWaiting, notEmpty, [&] { return (n = popSomeNoWake(out, maxCount)) != 0; });
+        wake(producersWaiting, notFull);
+        return n;
+    }
+
+private:
+    static constexpr size_t kCacheLine = 64;
+    static constexpr int kSpinCount = 256;   // try this many times before sleeping on the condition variable
+
+    struct Cell {
+        std::atomic<size_t> sequence;   // == pos: free for the producer of pos, == pos+1: full for the consumer of pos
+        T value;
+    };
+
+    // Claims the slot at the current index if its sequence says it is ready (expectedOffset 0 = free, 1 = full).
+    Cell* claim(std::atomic<size_t> &index, size_t expectedOffset, size_t &pos) {
+        pos = index.load(std::memory_order_relaxed);
+        while (true) {
+            Cell* cell = &cells[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + expectedOffset);
+            if (diff == 0) {
+                if (index.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) return cell;
+            } else if (diff < 0) {
+                return nullptr;   // empty (for consumers) or full (for producers)
+            } else {
+                pos = index.load(std::memory_order_relaxed);   // someone else took this slot
+            }
+        }
+    }
+
+    // Counts how many consecutive slots starting at the current index are ready, then claims them all at once.
+    size_t claimRange(std::atomic<size_t> &index, size_t expectedOffset, size_t maxCount, size_t &pos) {
+        pos = index.load(std::memory_order_relaxed);
+        while (true) {
+            size_t n = 0;
+            while (n < maxCount && n <= mask) {
+                size_t seq = cells[(pos + n) & mask].sequence.load(std::memory_order_acquire);
+                if (seq != pos + n + expectedOffset) break;
+                ++n;
+            }
+            if (n == 0) {
+                size_t seq = cells[pos & mask].sequence.load(std::memory_order_acquire);
+                if ((intptr_t)seq - (intptr_t)(pos + expectedOffset) < 0) return 0;
+                pos = index.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (index.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) return n;
+        }
+    }
+
+    template <typename U>
+    bool tryPushNoWake(U &&value) {
+        size_t pos;
+        Cell* cell = claim(enqueuePos, 0, pos);
+        if (!cell) return false;
+        cell->value = std::forward<U>(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPopNoWake(T &value) {
+        size_t pos;
+        Cell* cell = claim(dequeuePos, 1, pos);
+        if (!cell) return false;
+        value = std::move(cell->value);
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t tryPushSome(T* items, size_t count) {
+        size_t n = pushSomeNoWake(items, count);
+        if (n != 0) wake(consumersWaiting, notEmpty);
+        return n;
+    }
+
+    size_t tryPopSome(T* out, size_t maxCount) {
+        size_t n = popSomeNoWake(out, maxCount);
+        if (n != 0) wake(producersWaiting, notFull);
+        return n;
+    }
+
+    size_t pushSomeNoWake(T* items, size_t count) {
+        size_t pos;
+        size_t n = claimRange(enqueuePos, 0, count, pos);
+        for (size_t i = 0; i < n; ++i) {
+            Cell &cell = cells[(pos + i) & mask];
+            cell.value = std::move(items[i]);
+            cell.sequence.store(pos + i + 1, std::memory_order_release);
+        }
+        return n;
+    }
+
+    size_t popSomeNoWake(T* out, size_t maxCount) {
+        size_t pos;
+        size_t n = claimRange(dequeuePos, 1, maxCount, pos);
+        for (size_t i = 0; i < n; ++i) {
+            Cell &cell = cells[(pos + i) & mask];
+            out[i] = std::move(cell.value);
+            cell.sequence.store(pos + i + mask + 1, std::memory_order_release);
+        }
+        return n;
+    }
+
+    // Slow path. The waiter announces itself before re-checking the queue under the lock, and the other side
+    // only takes the lock when someone is waiting, so the fast path never touches the mutex.
+    // 'ready' must not call wake() itself (it runs with sleepMtx held); callers wake the other side afterwards.
+    template <typename Ready>
+    void waitUntil(std::atomic<int> &waiting, std::condition_variable &cv, Ready ready) {
+        waiting.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);   // pairs with the fence in wake()
+        {
+            std::unique_lock<std::mutex> lock(sleepMtx);
+            cv.wait(lock, ready);
+        }
+        waiting.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void wake(std::atomic<int> &waiting, std::condition_variable &cv) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);   // order our slot update before reading 'waiting'
+        if (waiting.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(sleepMtx);
+            cv.notify_all();
+        }
+    }
+
+    static void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+    static size_t roundUp(size_t n) {
+        size_t p = 2;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    std::vector<Cell> cells;
+    const size_t mask;
+
+    // Producers and consumers each hammer their own index; keep them on separate cache lines.
+    alignas(kCacheLine) std::atomic<size_t> enqueuePos{0};
+    alignas(kCacheLine) std::atomic<size_t> dequeuePos{0};
+    alignas(kCacheLine) std::atomic<int> producersWaiting{0};
+    std::atomic<int> consumersWaiting{0};
+    std::mutex sleepMtx;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+};
+
+#endif // BOUNDED_SAFE_QUEUE_H
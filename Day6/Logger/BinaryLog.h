@@ -0,0 +1,240 @@
+#ifndef BINARY_LOG_H
+#define BINARY_LOG_H
+
+// Deferred-formatting binary logging.
+//
+// Logger::log("Count: " + to_string(i)) builds a temporary string and formats the number on the calling thread.
+// With BINLOG the format string is registered once per call site (the first time that line runs), and every
+// call afterwards only copies a 4-byte site id plus the raw bytes of the arguments into a buffer:
+//
+//     BinaryLogger log("Log.bin");
+//     BINLOG(log, "Count: {} of {}", i, total);
+//
+// The text is produced later, offline, by binlog_decode.cpp. The log file is self-describing: the first time
+// a site is used in a file, its format string, argument types and source location are written as a definition record.
+//
+// Registration is lazy, neither at compile time nor during static initialisation: a function-local static in
+// BINLOG calls registerSite() the first time the line runs, and every later call still tests that static's guard
+// (one load and a well-predicted branch). The logger is single-lock: every write() takes its mutex, so threads
+// logging into the same BinaryLogger take turns.
+//
+// A full disk does not throw from write(): the bytes that could not be written are counted in lostBytes(), and
+// once a write has failed the rest of the log is dropped (a torn record would make the file undecodable).
+// flush() returns false when anything was lost; the destructor reports it on stderr.
+//
+// Record layout (little-endian, no padding):
+//   definition: u32 0, u32 siteId, u32 line, str signature, str format, str file   (str = u32 length + bytes)
+//   event:      u32 siteId, then every argument: raw bytes for numbers, str for strings
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace binlog {
+
+const char kMagic[8] = {'B', 'I', 'N', 'L', 'O', 'G', '0', '1'};
+const uint32_t kDefinitionTag = 0;   // site ids start at 1
+
+// One character per argument type; stored in the definition record so the decoder knows how to read the event.
+// Integers are described by size and signedness: a/A = 8 bit, h/H = 16, i/I = 32, l/L = 64 (upper case = unsigned).
+constexpr char integerCode(size_t size, bool isSigned) {
+    return size == 1 ? (isSigned ? 'a' : 'A')
+         : size == 2 ? (isSigned ? 'h' : 'H')
+         : size == 4 ? (isSigned ? 'i' : 'I')
+         : (isSigned ? 'l' : 'L');
+}
+
+template <typename T, typename = void> struct TypeCode;
+template <> struct TypeCode<bool> { static constexpr char value = 'b'; };
+template <> struct TypeCode<char> { static constexpr char value = 'c'; };
+template <typename T>
+struct TypeCode<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value &&
+                                           !std::is_same<T, char>::value>::type> {
+    static constexpr char value = integerCode(sizeof(T), std::is_signed<T>::value);
+};
+template <> struct TypeCode<float> { static constexpr char value = 'f'; };
+template <> struct TypeCode<double> { static constexpr char value = 'd'; };
+template <> struct TypeCode<const char*> { static constexpr char value = 's'; };
+template <> struct TypeCode<char*> { static constexpr char value = 's'; };
+template <> struct TypeCode<std::string> { static constexpr char value = 's'; };
+template <size_t N> struct TypeCode<char[N]> { static constexpr char value = 's'; };
+
+template <typename T>
+using Decayed = typename std::remove_cv<typename std::remove_reference<T>::type>::type;
+
+template <typename... Args>
+struct Signature {
+    static const char* get() {
+        static const char sig[] = {TypeCode<Args>::value..., '\0'};
+        return sig;
+    }
+};
+
+// Only used inside decltype() by BINLOG, so the arguments are never evaluated twice.
+// The first parameter takes the format string, which is not part of the signature.
+template <typename... Args>
+Signature<Decayed<Args>...> signatureOf(const char* format, const Args&...);
+
+struct Site {
+    const char* format;
+    const char* signature;
+    const char* file;
+    uint32_t line;
+};
+
+// Global table of call sites. Registration happens once per site (function-local static in BINLOG).
+inline std::vector<Site>& sites() {
+    static std::vector<Site> table;
+    return table;
+}
+
+inline std::mutex& sitesMutex() {
+    static std::mutex mtx;
+    return mtx;
+}
+
+inline uint32_t registerSite(const char* format, const char* signature, const char* file, uint32_t line) {
+    std::lock_guard<std::mutex> lock(sitesMutex());
+    sites().push_back(Site{format, signature, file, line});
+    return (uint32_t)sites().size();   // ids start at 1; 0 is the definition tag
+}
+
+class BinaryLogger {
+public:
+    explicit BinaryLogger(const std::string& filename, size_t bufferSize = 64 * 1024) : capacity(bufferSize) {
+        file = std::fopen(filename.c_str(), "wb");
+        if (!file) {
+            throw std::runtime_error("Failed to open binary log file: " + filename);
+        }
+        std::setvbuf(file, nullptr, _IONBF, 0);   // 'buffer' does the batching; fwrite() then reports short writes exactly
+        buffer.resize(capacity + 256);
+        append(kMagic, sizeof(kMagic));
+    }
+
+    // A destructor must not throw: lost records are reported on stderr.
+    ~BinaryLogger() {
+        bool ok = flush();
+        if (std::fclose(file) != 0) ok = false;
+        if (!ok) {
+            std::fprintf(stderr, "BinaryLogger: %llu bytes of log lost, write failed\n", (unsigned long long)lost);
+        }
+    }
+
+    BinaryLogger(const BinaryLogger&) = delete;
+    BinaryLogger& operator=(const BinaryLogger&) = delete;
+
+    // BINLOG passes the format string along with the arguments; it is already in the site table.
+    template <typename... Args>
+    void write(uint32_t siteId, const char* /*format*/, const Args&... args) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (siteId >= defined.size() || !defined[siteId]) {
+            define(siteId);
+        }
+        put(siteId);
+        int expand[] = {0, (put(args), 0)...};
+        (void)expand;
+        if (used >= capacity) {
+            flushLocked();
+        }
+    }
+
+    // Hands the buffer to the file; returns false if any log data has been lost so far.
+    bool flush() {
+        std::lock_guard<std::mutex> lock(mtx);
+        flushLocked();
+        return !failed;
+    }
+
+    uint64_t lostBytes() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return lost;
+    }
+
+private:
+    // Plain memcpy into a preallocated buffer; it only grows for records with very long strings.
+    void append(const void* data, size_t size) {
+        if (used + size > buffer.size()) {
+            buffer.resize((used + size) * 2);
+        }
+        std::memcpy(buffer.data() + used, data, size);
+        used += size;
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_arithmetic<T>::value>::type put(const T& value) {
+        append(&value, sizeof(value));
+    }
+
+    void putString(const char* s, size_t length) {
+        uint32_t n = (uint32_t)length;
+        append(&n, sizeof(n));
+        append(s, n);
+    }
+
+    void put(const char* s) { putString(s, std::strlen(s)); }
+    void put(const std::string& s) { putString(s.data(), s.size()); }
+
+    void define(uint32_t siteId) {
+        Site site;
+        {
+            std::lock_guard<std::mutex> lock(sitesMutex());
+            site = sites().at(siteId - 1);
+        }
+        put(kDefinitionTag);
+        put(siteId);
+        put(site.line);
+        put(site.signature);
+        put(site.format);
+        put(site.file);
+        if (siteId >= defined.size()) defined.resize(siteId + 1, false);
+        defined[siteId] = true;
+    }
+
+    void flushLocked() {
+        if (failed) {   // the file ends in a torn record; nothing after it could be decoded
+            lost += used;
+            used = 0;
+            return;
+        }
+        if (used != 0) {
+            size_t written = std::fwrite(buffer.data(), 1, used, file);
+            if (written < used) {
+                failed = true;
+                lost += used - written;
+            }
+            used = 0;
+        }
+        if (std::fflush(file) != 0) failed = true;
+    }
+
+    std::FILE* file;
+    size_t capacity;
+    std::vector<char> buffer;
+    size_t used = 0;
+    bool failed = false;         // a write to the file failed
+    uint64_t lost = 0;           // bytes of log that did not reach the file
+    std::vector<bool> defined;   // sites whose definition record is already in this file
+    std::mutex mtx;
+};
+
+} // namespace binlog
+
+// Logs one event: BINLOG(logger, format, args...). The format string must be a string literal; "{}" marks
+// where each argument goes. The format is the first of the variadic arguments, so a call without arguments
+// needs neither ##__VA_ARGS__ nor __VA_OPT__ and the macro stays standard C++17.
+#define BINLOG(logger, ...)                                                                             \
+    do {                                                                                                \
+        static const uint32_t binlogSiteId_ = ::binlog::registerSite(                                   \
+            BINLOG_FORMAT_(__VA_ARGS__, 0), decltype(::binlog::signatureOf(__VA_ARGS__))::get(),        \
+            __FILE__, __LINE__);                                                                        \
+        (logger).write(binlogSiteId_, __VA_ARGS__);                                                     \
+    } while (0)
+
+#define BINLOG_FORMAT_(format, ...) format
+
+#endif // BINARY_LOG_H
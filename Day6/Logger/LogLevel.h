@@ -0,0 +1,121 @@
+#ifndef LOG_LEVEL_H
+#define LOG_LEVEL_H
+
+// Leveled logging on top of any logger with a log(const string&) method (Logger.h, challeng6_3.cpp).
+//
+//     LOG_MODULE(sensorLog, "sensor", LogLevel::Info);       // one runtime threshold per module
+//     LOG_DEBUG(logger, sensorLog, "raw value ", value);     // message parts are only formatted if enabled
+//     LOG_INFO(logger, sensorLog);                            // no message parts: just "[INFO] [sensor] "
+//
+// Two filters:
+// 1. Compile time: build with -DLOG_COMPILE_LEVEL=LOG_LEVEL_INFO (the default when NDEBUG is set) and every
+//    LOG_TRACE / LOG_DEBUG expands to nothing. The arguments disappear too, so they are never evaluated.
+// 2. Runtime: each module has an atomic threshold. An enabled-at-compile-time call costs one relaxed atomic load
+//    and a compare when it is filtered out; the message is built only after the check passes.
+
+#include <atomic>
+#include <sstream>
+#include <string>
+
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO  2
+#define LOG_LEVEL_WARN  3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_OFF   5
+
+#ifndef LOG_COMPILE_LEVEL
+#ifdef NDEBUG
+#define LOG_COMPILE_LEVEL LOG_LEVEL_INFO
+#else
+#define LOG_COMPILE_LEVEL LOG_LEVEL_TRACE
+#endif
+#endif
+
+enum class LogLevel : int {
+    Trace = LOG_LEVEL_TRACE,
+    Debug = LOG_LEVEL_DEBUG,
+    Info = LOG_LEVEL_INFO,
+    Warn = LOG_LEVEL_WARN,
+    Error = LOG_LEVEL_ERROR,
+    Off = LOG_LEVEL_OFF
+};
+
+inline const char* levelName(LogLevel level) {
+    static const char* names[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "OFF"};
+    return names[(int)level];
+}
+
+// A named group of log calls (a file, a driver, a subsystem) with its own runtime threshold.
+class LogModule {
+public:
+    LogModule(const char* name, LogLevel threshold) : name_(name), threshold_((int)threshold) {}
+
+    bool enabled(LogLevel level) const {
+        return (int)level >= threshold_.load(std::memory_order_relaxed);
+    }
+
+    void setLevel(LogLevel level) { threshold_.store((int)level, std::memory_order_relaxed); }
+    const char* name() const { return name_; }
+
+private:
+    const char* name_;
+    std::atomic<int> threshold_;
+};
+
+#define LOG_MODULE(variable, name, level) LogModule variable(name, level)
+
+// Builds "[LEVEL] [module] part1part2..." and hands it to logger.log(). Only called after the level checks.
+template <typename LoggerT, typename... Parts>
+void logFormatted(LoggerT& logger, LogLevel level, const LogModule& module, const Parts&... parts) {
+    std::ostringstream message;
+    message << '[' << levelName(level) << "] [" << module.name() << "] ";
+    int expand[] = {0, ((message << parts), 0)...};
+    (void)expand;
+    logger.log(message.str());
+}
+
+// The module is the first of the variadic arguments, so a call without message parts is still standard C++
+// (no ##__VA_ARGS__ or __VA_OPT__, same as BINLOG in BinaryLog.h).
+#define LOG_AT_LEVEL_(level, logger, ...)                               \
+    do {                                                                \
+        if (LOG_MODULE_OF_(__VA_ARGS__, 0).enabled(level)) {            \
+            logFormatted((logger), (level), __VA_ARGS__);               \
+        }                                                               \
+    } while (0)
+
+#define LOG_MODULE_OF_(module, ...) (module)
+
+#define LOG_DISABLED_(...) do { } while (0)
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_TRACE
+#define LOG_TRACE(logger, ...) LOG_AT_LEVEL_(LogLevel::Trace, logger, __VA_ARGS__)
+#else
+#define LOG_TRACE(...) LOG_DISABLED_(__VA_ARGS__)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(logger, ...) LOG_AT_LEVEL_(LogLevel::Debug, logger, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) LOG_DISABLED_(__VA_ARGS__)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(logger, ...) LOG_AT_LEVEL_(LogLevel::Info, logger, __VA_ARGS__)
+#else
+#define LOG_INFO(...) LOG_DISABLED_(__VA_ARGS__)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(logger, ...) LOG_AT_LEVEL_(LogLevel::Warn, logger, __VA_ARGS__)
+#else
+#define LOG_WARN(...) LOG_DISABLED_(__VA_ARGS__)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(logger, ...) LOG_AT_LEVEL_(LogLevel::Error, logger, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) LOG_DISABLED_(__VA_ARGS__)
+#endif
+
+#endif // LOG_LEVEL_H
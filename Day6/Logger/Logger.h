@@ -3,16 +3,49 @@
 
 #include <string>
 #include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 
 using namespace std;
+
+// When the background writer swaps buffers and writes them to the file.
+// A zero value disables that trigger; with both at zero the buffer is only written on flush() or shutdown.
+struct FlushPolicy {
+    size_t maxBufferBytes = 64 * 1024;         // Swap as soon as the front buffer reaches this size.
+    chrono::milliseconds interval{100};        // Swap at least this often while there is pending data.
+};
+
 class Logger {
 public:
-    Logger(const string& filename);
-    ~Logger();
+    enum class Mode {
+        Sync,   // Every log() call writes and flushes the file on the caller's thread.
+        Async   // log() appends to a front buffer; a background writer writes whole blocks.
+    };
+
+    Logger(const string& filename, Mode mode = Mode::Sync, FlushPolicy policy = FlushPolicy());
+    ~Logger();   // In async mode, drains every buffered message before closing the file.
     void log(const string& message);
+    void flush();
 
 private:
+    void writerLoop();
+
      ofstream logfile;
+     Mode mode;
+     FlushPolicy policy;
+
+     // Async mode state: callers fill 'front', the writer thread owns 'back'.
+     string front;
+     string back;
+     mutex mtx;
+     condition_variable wakeWriter;
+     condition_variable flushed;
+     unsigned long flushRequests = 0;   // Incremented by flush(), answered by the writer.
+     unsigned long flushesDone = 0;
+     bool stop = false;
+     thread writer;
 };
 
 #endif // LOGGER_H
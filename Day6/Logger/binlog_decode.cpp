@@ -0,0 +1,148 @@
+// Offline decoder for binary logs written with BINLOG (BinaryLog.h).
+// Usage: binlog_decode Log.bin > Log.txt
+//
+// Every definition record tells the decoder the format string and argument types of a site;
+// every event record is then turned back into text by replacing each "{}" with the next argument.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include "BinaryLog.h"
+
+using namespace std;
+
+struct SiteInfo {
+    string signature;
+    string format;
+    string file;
+    uint32_t line = 0;
+    bool defined = false;   // an empty format string is still a definition
+};
+
+class Reader {
+public:
+    Reader(const vector<char> &data) : data(data) {}
+
+    bool atEnd() const { return pos >= data.size(); }
+
+    template <typename T>
+    T read() {
+        T value;
+        need(sizeof(T));
+        memcpy(&value, data.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    string readString() {
+        uint32_t n = read<uint32_t>();
+        need(n);
+        string s(data.data() + pos, n);
+        pos += n;
+        return s;
+    }
+
+    void skip(size_t n) {
+        need(n);
+        pos += n;
+    }
+
+private:
+    void need(size_t n) const {
+        if (pos + n > data.size()) throw runtime_error("truncated record");
+    }
+
+    const vector<char> &data;
+    size_t pos = 0;
+};
+
+// Reads one argument of the given type code and prints it.
+void printArgument(Reader &in, char code, ostream &out) {
+    switch (code) {
+    case 'b': out << (in.read<bool>() ? "true" : "false"); break;
+    case 'c': out << in.read<char>(); break;
+    case 'a': out << (int)in.read<int8_t>(); break;
+    case 'A': out << (unsigned)in.read<uint8_t>(); break;
+    case 'h': out << in.read<int16_t>(); break;
+    case 'H': out << in.read<uint16_t>(); break;
+    case 'i': out << in.read<int32_t>(); break;
+    case 'I': out << in.read<uint32_t>(); break;
+    case 'l': out << in.read<int64_t>(); break;
+    case 'L': out << in.read<uint64_t>(); break;
+    case 'f': out << in.read<float>(); break;
+    case 'd': out << in.read<double>(); break;
+    case 's': out << in.readString(); break;
+    default: throw runtime_error(string("unknown argument type '") + code + "'");
+    }
+}
+
+void printEvent(Reader &in, const SiteInfo &site, ostream &out) {
+    const string &fmt = site.format;
+    size_t arg = 0;
+    for (size_t i = 0; i < fmt.size(); ++i) {
+        if (fmt[i] == '{' && i + 1 < fmt.size() && fmt[i + 1] == '}' && arg < site.signature.size()) {
+            printArgument(in, site.signature[arg++], out);
+            ++i;
+        } else {
+            out << fmt[i];
+        }
+    }
+    for (; arg < site.signature.size(); ++arg) {   // more arguments than placeholders: append them
+        out << ' ';
+        printArgument(in, site.signature[arg], out);
+    }
+    out << '\n';
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        cerr << "Usage: " << argv[0] << " <binary log file>" << endl;
+        return 1;
+    }
+
+    ifstream file(argv[1], ios::binary);
+    if (!file) {
+        cerr << "Failed to open " << argv[1] << endl;
+        return 1;
+    }
+    vector<char> data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+    if (data.size() < sizeof(binlog::kMagic) || memcmp(data.data(), binlog::kMagic, sizeof(binlog::kMagic)) != 0) {
+        cerr << argv[1] << " is not a binary log" << endl;
+        return 1;
+    }
+
+    Reader in(data);
+    in.skip(sizeof(binlog::kMagic));
+    vector<SiteInfo> sites;
+    try {
+        while (!in.atEnd()) {
+            uint32_t id = in.read<uint32_t>();
+            if (id == binlog::kDefinitionTag) {
+                uint32_t siteId = in.read<uint32_t>();
+                SiteInfo site;
+                site.line = in.read<uint32_t>();
+                site.signature = in.readString();
+                site.format = in.readString();
+                site.file = in.readString();
+                site.defined = true;
+                if (siteId >= sites.size()) sites.resize(siteId + 1);
+                sites[siteId] = site;
+            } else {
+                if (id >= sites.size() || !sites[id].defined) {
+                    throw runtime_error("event for undefined site " + to_string(id));
+                }
+                printEvent(in, sites[id], cout);
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Stopped decoding: " << e.what() << endl;   // e.g. the program crashed while writing the last record
+        return 1;
+    }
+
+    return 0;
+}
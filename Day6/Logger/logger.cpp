@@ -2,21 +2,98 @@
 #include <iostream>
 using namespace std;
 
-Logger::Logger(const string& filename) : logfile(filename, ios::out | ios::app) {
+Logger::Logger(const string& filename, Mode mode, FlushPolicy policy)
+    : logfile(filename, ios::out | ios::app), mode(mode), policy(policy) {
     if (!logfile.is_open()) {
         cerr << "Failed to open log file!" << std::endl;
         exit(EXIT_FAILURE);
     }
+    if (mode == Mode::Async) {
+        front.reserve(policy.maxBufferBytes);
+        back.reserve(policy.maxBufferBytes);
+        writer = thread(&Logger::writerLoop, this);
+    }
 }
 
 Logger::~Logger() {
+    if (writer.joinable()) {
+        {
+            lock_guard<mutex> lock(mtx);
+            stop = true;
+        }
+        wakeWriter.notify_one();
+        writer.join();   // The writer only exits after the front buffer is empty.
+    }
     if (logfile.is_open()) {
         logfile.close();
     }
 }
 
 void Logger::log(const string& message) {
-    logfile << message << endl;
+    if (mode == Mode::Sync) {
+        logfile << message << endl;
+        return;
+    }
+
+    bool full;
+    {
+        lock_guard<mutex> lock(mtx);
+        front += message;
+        front += '\n';
+        full = policy.maxBufferBytes != 0 && front.size() >= policy.maxBufferBytes;
+    }
+    if (full) {
+        wakeWriter.notify_one();   // Only wake the writer when a block is ready, not on every call.
+    }
+}
+
+// Blocks until everything logged before this call has reached the file.
+void Logger::flush() {
+    if (mode == Mode::Sync) {
+        logfile.flush();
+        return;
+    }
+
+    unique_lock<mutex> lock(mtx);
+    unsigned long ticket = ++flushRequests;
+    wakeWriter.notify_one();
+    flushed.wait(lock, [this, ticket] { return flushesDone >= ticket; });
+}
+
+void Logger::writerLoop() {
+    unique_lock<mutex> lock(mtx);
+    while (true) {
+        auto ready = [this] {
+            return stop || flushRequests != flushesDone ||
+                   (policy.maxBufferBytes != 0 && front.size() >= policy.maxBufferBytes);
+        };
+        if (policy.interval.count() > 0) {
+            wakeWriter.wait_for(lock, policy.interval, ready);
+        } else {
+            wakeWriter.wait(lock, ready);
+        }
+
+        unsigned long answering = flushRequests;
+        bool exiting = stop;
+        front.swap(back);   // Callers continue into the (now empty) front buffer while we write.
+
+        lock.unlock();
+        if (!back.empty()) {
+            logfile.write(back.data(), back.size());
+            logfile.flush();
+            back.clear();
+        }
+        lock.lock();
+
+        if (answering != flushesDone) {
+            flushesDone = answering;
+            flushed.notify_all();
+        }
+        // stop is only set from the destructor, so no new messages can arrive after this swap.
+        if (exiting && front.empty()) {
+            return;
+        }
+    }
 }
 
 
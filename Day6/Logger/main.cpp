@@ -4,7 +4,7 @@
 using namespace std;
 
 int main() {
-    Logger logger("Log.txt");
+    Logger logger("Log.txt", Logger::Mode::Async);   // log() only appends to a buffer; a background thread writes it
 
     for (int i = 0; i <= 10; ++i) {
         logger.log("Count: " + to_string(i));
@@ -31,4 +31,9 @@ String Concatenation:
 
 logger.log:
 This calls the log method of the Logger instance logger, passing the concatenated string as an argument.
-The log method writes this string to the log file (Log.txt), followed by a newline.*/
\ No newline at end of file
+The log method writes this string to the log file (Log.txt), followed by a newline.
+
+Logger::Mode::Async:
+In async mode log() does not touch the file. It appends the message to a front buffer, and a background
+writer thread swaps the front and back buffers and writes the whole block at once (see FlushPolicy).
+The Logger destructor waits for the writer to drain everything, so no lines are lost at the end of main.*/
\ No newline at end of file
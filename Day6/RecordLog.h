@@ -0,0 +1,295 @@
+#ifndef RECORD_LOG_H
+#define RECORD_LOG_H
+
+// Binary, append-only record file used by the binary DataLogger (challeng6_5.cpp).
+//
+// File layout:
+//   FileHeader  (16 bytes: magic "DLOG", version, reserved)
+//   Record*     each record = RecordHeader (16 bytes) + payload, padded to a multiple of 8 bytes
+//
+// RecordWriter keeps the file descriptor open and batches records in a user-space buffer.
+// RecordReader maps the whole file with mmap() and hands out views that point straight into the mapping,
+// so reading never copies or parses text. A sparse index (one offset every kIndexStride records) gives
+// random access without storing an offset per record.
+//
+// POSIX only (open/write/mmap).
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace recordlog {
+
+const uint32_t kMagic = 0x474F4C44;   // "DLOG" in little-endian
+const uint16_t kVersion = 1;
+
+struct FileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved0;
+    uint64_t reserved1;
+};
+
+struct RecordHeader {
+    uint32_t length;       // payload size in bytes (without header and padding)
+    uint16_t producerId;
+    uint16_t reserved;
+    uint64_t timestampNs;  // nanoseconds since the epoch of system_clock
+};
+
+static_assert(sizeof(FileHeader) == 16, "FileHeader must be 16 bytes");
+static_assert(sizeof(RecordHeader) == 16, "RecordHeader must be 16 bytes");
+
+inline size_t paddedSize(size_t payload) {
+    return sizeof(RecordHeader) + ((payload + 7) & ~size_t(7));
+}
+
+inline uint64_t nowNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+class RecordWriter {
+public:
+    explicit RecordWriter(const std::string& filename, size_t bufferSize = 64 * 1024) : capacity(bufferSize) {
+        fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open record file: " + filename);
+        }
+        buffer.reserve(capacity);
+
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size == 0) {
+            FileHeader header = {kMagic, kVersion, 0, 0};
+            append(&header, sizeof(header));
+        }
+    }
+
+    // A destructor must not throw: if the last records cannot be written, that is reported on stderr.
+    ~RecordWriter() {
+        if (!flushNoThrow()) std::fprintf(stderr, "RecordWriter: buffered records lost, write failed\n");
+        ::close(fd);
+    }
+
+    RecordWriter(const RecordWriter&) = delete;
+    RecordWriter& operator=(const RecordWriter&) = delete;
+
+    // Appends one record. Thread-safe; records from different threads are never interleaved.
+    void write(uint16_t producerId, const void* payload, uint32_t length, uint64_t timestampNs = nowNs()) {
+        RecordHeader header = {length, producerId, 0, timestampNs};
+        static const char zeros[8] = {};
+        size_t padding = paddedSize(length) - sizeof(RecordHeader) - length;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        if (buffer.size() + paddedSize(length) > capacity) {
+            flushLocked();
+        }
+        append(&header, sizeof(header));
+        append(payload, length);
+        append(zeros, padding);
+    }
+
+    // Hands the buffered records to the kernel. Throws std::runtime_error if write() fails.
+    void flush() {
+        std::lock_guard<std::mutex> lock(mtx);
+        flushLocked();
+    }
+
+    // Same as flush(), for places that cannot throw; returns false if write() failed.
+    bool flushNoThrow() noexcept {
+        try {
+            flush();
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+
+private:
+    void append(const void* data, size_t size) {
+        const char* p = static_cast<const char*>(data);
+        buffer.insert(buffer.end(), p, p + size);
+    }
+
+    // On failure the bytes already written are dropped from the buffer, so a later flush() does not write
+    // them a second time.
+    void flushLocked() {
+        size_t done = 0;
+        while (done < buffer.size()) {
+            ssize_t n = ::write(fd, buffer.data() + done, buffer.size() - done);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                buffer.erase(buffer.begin(), buffer.begin() + done);
+                throw std::runtime_error("Failed to write record file");
+            }
+            done += (size_t)n;
+        }
+        buffer.clear();
+    }
+
+    int fd = -1;
+    size_t capacity;
+    std::vector<char> buffer;
+    std::mutex mtx;
+};
+
+// A record inside the mapped file. 'payload' points into the mapping and stays valid while the reader lives.
+struct RecordView {
+    uint64_t timestampNs;
+    uint16_t producerId;
+    uint32_t length;
+    const unsigned char* payload;
+
+    // Typed view of the payload, e.g. record.as<int32_t>() for a record written from a vector<int32_t>.
+    template <typename T>
+    const T* as() const { return reinterpret_cast<const T*>(payload); }
+    template <typename T>
+    size_t count() const { return length / sizeof(T); }
+};
+
+class RecordReader {
+public:
+    static constexpr size_t kIndexStride = 1024;   // one index entry every 1024 records
+
+    explicit RecordReader(const std::string& filename) {
+        fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open record file: " + filename);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Failed to stat record file: " + filename);
+        }
+        size = (size_t)st.st_size;
+        if (size > 0) {
+            void* p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Failed to mmap record file: " + filename);
+            }
+            base = static_cast<const unsigned char*>(p);
+            ::madvise(p, size, MADV_SEQUENTIAL);
+        }
+
+        FileHeader header = {};
+        if (size >= sizeof(header)) {
+            std::memcpy(&header, base, sizeof(header));
+        }
+        if (header.magic != kMagic || header.version != kVersion) {
+            close();
+            throw std::runtime_error("Not a record file: " + filename);
+        }
+    }
+
+    ~RecordReader() { close(); }
+
+    RecordReader(const RecordReader&) = delete;
+    RecordReader& operator=(const RecordReader&) = delete;
+
+    class Iterator {
+    public:
+        Iterator(const RecordReader* reader, size_t offset) : reader(reader), offset(offset) {}
+        RecordView operator*() const { return reader->viewAt(offset); }
+        Iterator& operator++() {
+            offset = reader->next(offset);
+            return *this;
+        }
+        bool operator!=(const Iterator& other) const { return offset != other.offset; }
+
+    private:
+        const RecordReader* reader;
+        size_t offset;
+    };
+
+    // Sequential, zero-copy iteration: for (RecordView r : reader) { ... }
+    Iterator begin() const { return Iterator(this, firstOffset()); }
+    Iterator end() const { return Iterator(this, endOffset()); }
+
+    // Number of complete records. Builds the sparse index on first use.
+    size_t count() const {
+        buildIndex();
+        return recordCount;
+    }
+
+    // Random access: jump to the nearest indexed record, then skip at most kIndexStride - 1 headers.
+    RecordView at(size_t i) const {
+        buildIndex();
+        if (i >= recordCount) {
+            throw std::out_of_range("record index out of range");
+        }
+        size_t offset = index[i / kIndexStride];
+        for (size_t k = i % kIndexStride; k > 0; --k) {
+            offset = next(offset);
+        }
+        return viewAt(offset);
+    }
+
+private:
+    // A record is valid if its header and padded payload lie completely inside the file;
+    // a torn record at the end of the file (crash while writing) is simply ignored.
+    bool valid(size_t offset) const {
+        if (offset + sizeof(RecordHeader) > size) return false;
+        uint32_t length;
+        std::memcpy(&length, base + offset, sizeof(length));
+        return offset + paddedSize(length) <= size;
+    }
+
+    size_t next(size_t offset) const {
+        uint32_t length;
+        std::memcpy(&length, base + offset, sizeof(length));
+        size_t n = offset + paddedSize(length);
+        return valid(n) ? n : endOffset();
+    }
+
+    size_t firstOffset() const { return valid(sizeof(FileHeader)) ? sizeof(FileHeader) : endOffset(); }
+    size_t endOffset() const { return size; }
+
+    RecordView viewAt(size_t offset) const {
+        RecordHeader header;
+        std::memcpy(&header, base + offset, sizeof(header));
+        return RecordView{header.timestampNs, header.producerId, header.length, base + offset + sizeof(header)};
+    }
+
+    // Walks the record headers once (payloads are skipped, not touched) and remembers every kIndexStride-th offset.
+    void buildIndex() const {
+        if (indexBuilt) return;
+        size_t offset = firstOffset();
+        while (offset != endOffset()) {
+            if (recordCount % kIndexStride == 0) index.push_back(offset);
+            ++recordCount;
+            offset = next(offset);
+        }
+        indexBuilt = true;
+    }
+
+    void close() {
+        if (base) ::munmap(const_cast<unsigned char*>(base), size);
+        if (fd >= 0) ::close(fd);
+        base = nullptr;
+        fd = -1;
+    }
+
+    int fd = -1;
+    size_t size = 0;
+    const unsigned char* base = nullptr;
+
+    mutable bool indexBuilt = false;
+    mutable size_t recordCount = 0;
+    mutable std::vector<size_t> index;
+};
+
+} // namespace recordlog
+
+#endif // RECORD_LOG_H
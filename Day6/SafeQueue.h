@@ -0,0 +1,50 @@
+#ifndef SAFE_QUEUE_H
+#define SAFE_QUEUE_H
+
+// The thread-safe queue of challeng6_2.cpp, shared by the programs that measure it (challeng6_7.cpp,
+// challeng6_8.cpp, challeng6_9.cpp). The member is named 'items': challeng6_2.cpp calls it 'queue',
+// which g++ rejects because it hides std::queue. Values are moved in and out instead of copied.
+//
+// A program can see inside push() and pop() by defining SAFE_QUEUE_SCOPE before including this header,
+// e.g. as TRACE_SCOPE (Trace.h) in challeng6_7.cpp; by default it expands to nothing.
+
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <utility>
+
+#ifndef SAFE_QUEUE_SCOPE
+#define SAFE_QUEUE_SCOPE(name) do { } while (0)
+#endif
+
+template <typename T>
+class SafeQueue {
+private:
+    std::queue<T> items;
+    std::mutex mtx;
+    std::condition_variable cv;
+
+public:
+    void push(T value) {
+        SAFE_QUEUE_SCOPE("SafeQueue::push");
+        std::lock_guard<std::mutex> lock(mtx);
+        SAFE_QUEUE_SCOPE("SafeQueue::push lock held");
+        items.push(std::move(value));
+        cv.notify_one();
+    }
+
+    bool pop(T &value) {
+        SAFE_QUEUE_SCOPE("SafeQueue::pop");
+        std::unique_lock<std::mutex> lock(mtx);
+        {
+            SAFE_QUEUE_SCOPE("SafeQueue::pop wait");   // time spent waiting for an element
+            cv.wait(lock, [this]{ return !items.empty(); });
+        }
+        SAFE_QUEUE_SCOPE("SafeQueue::pop lock held");
+        value = std::move(items.front());
+        items.pop();
+        return true;
+    }
+};
+
+#endif // SAFE_QUEUE_H
@@ -0,0 +1,181 @@
+#ifndef SAMPLE_INGEST_H
+#define SAMPLE_INGEST_H
+
+// Typed, batched sensor sample ingestion.
+//
+// challeng6_2.cpp turns every reading into "Sensor value: " + to_string(v), a heap-allocated string that is
+// moved through SafeQueue<string> only to be printed. Here a reading is a fixed-size Sample, producers write
+// samples into pre-allocated blocks of 256, and only the pointer to a full block goes through the queue:
+//
+//     ingest::Ingest channel(64);                  // 64 blocks allocated once, reused forever
+//     // producer thread
+//     ingest::SampleWriter writer(channel);
+//     writer.write(sensorId, value);               // no allocation, no lock until a block is full
+//     writer.flush();                              // hand over a partly filled block
+//     // consumer thread
+//     while (ingest::SampleBlock* block = channel.receive()) {
+//         ... block->samples[0 .. block->count) ...
+//         channel.release(block);                  // back to the pool for the producers
+//     }
+//     // when all producers are done
+//     channel.close(consumerCount);                // every consumer's receive() then returns nullptr
+//
+// The number of blocks bounds the memory: when every block is in flight, acquire() waits for a consumer to
+// release one (back-pressure instead of an ever-growing queue). Text is produced only at the output edge,
+// with appendText(), into a buffer that is reused from block to block.
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "BoundedSafeQueue.h"
+
+namespace ingest {
+
+enum SampleFlags : uint32_t {
+    kSampleValid = 1u << 0,
+    kSampleOutOfRange = 1u << 1,
+    kSampleCalibrated = 1u << 2,
+};
+
+struct Sample {
+    int64_t timestampNs;   // steady clock
+    double value;
+    uint32_t sensorId;
+    uint32_t flags;        // SampleFlags
+};
+static_assert(sizeof(Sample) == 24, "Sample is a fixed 24-byte record");
+static_assert(std::is_trivially_copyable<Sample>::value, "Sample must be copyable with memcpy");
+
+inline int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct SampleBlock {
+    static const uint32_t kCapacity = 256;
+
+    uint32_t count = 0;
+    Sample samples[kCapacity];
+
+    bool full() const { return count == kCapacity; }
+};
+
+class Ingest {
+public:
+    explicit Ingest(size_t blockCount)
+        : blocks(blockCount), freeBlocks(blockCount), readyBlocks(blockCount + 1) {
+        for (SampleBlock& b : blocks) freeBlocks.push(&b);
+    }
+
+    Ingest(const Ingest&) = delete;
+    Ingest& operator=(const Ingest&) = delete;
+
+    // Producer side. acquire() waits while all blocks are in use.
+    SampleBlock* acquire() {
+        SampleBlock* block;
+        freeBlocks.pop(block);
+        block->count = 0;
+        return block;
+    }
+
+    void submit(SampleBlock* block) { readyBlocks.push(block); }
+
+    // Consumer side. Returns nullptr once close() has been called and the queue is drained for this consumer.
+    SampleBlock* receive() {
+        SampleBlock* block;
+        readyBlocks.pop(block);
+        return block;
+    }
+
+    void release(SampleBlock* block) { freeBlocks.push(block); }
+
+    // Call after the last submit(): wakes each of the 'consumers' threads with an end marker.
+    void close(size_t consumers) {
+        for (size_t i = 0; i < consumers; ++i) readyBlocks.push(nullptr);
+    }
+
+    size_t blockCount() const { return blocks.size(); }
+
+private:
+    std::vector<SampleBlock> blocks;               // all the memory the channel will ever use
+    BoundedSafeQueue<SampleBlock*> freeBlocks;
+    BoundedSafeQueue<SampleBlock*> readyBlocks;
+};
+
+// Fills blocks for one producer thread and submits each one when it is full. Not thread-safe: one per producer.
+class SampleWriter {
+public:
+    explicit SampleWriter(Ingest& channel) : channel(channel) {}
+    ~SampleWriter() { flush(); }
+
+    SampleWriter(const SampleWriter&) = delete;
+    SampleWriter& operator=(const SampleWriter&) = delete;
+
+    void write(uint32_t sensorId, double value, uint32_t flags = kSampleValid, int64_t timestampNs = nowNs()) {
+        write(Sample{timestampNs, value, sensorId, flags});
+    }
+
+    void write(const Sample& sample) {
+        if (!block) block = channel.acquire();
+        block->samples[block->count++] = sample;
+        if (block->full()) submitBlock();
+    }
+
+    void writeBatch(const Sample* samples, size_t n) {
+        while (n > 0) {
+            if (!block) block = channel.acquire();
+            size_t room = SampleBlock::kCapacity - block->count;
+            size_t take = n < room ? n : room;
+            std::copy(samples, samples + take, block->samples + block->count);
+            block->count += (uint32_t)take;
+            samples += take;
+            n -= take;
+            if (block->full()) submitBlock();
+        }
+    }
+
+    // Hands over a partly filled block (for example at the end of a burst, so the consumer sees it now).
+    void flush() {
+        if (block && block->count > 0) submitBlock();
+    }
+
+private:
+    void submitBlock() {
+        channel.submit(block);
+        block = nullptr;
+    }
+
+    Ingest& channel;
+    SampleBlock* block = nullptr;
+};
+
+// Output edge: appends "sensor=<id> t=<ns> value=<v> flags=<f>\n" for every sample of the block.
+// 'out' keeps its capacity between calls, so after the first block no allocation happens here either.
+inline void appendText(const SampleBlock& block, std::string& out) {
+    const size_t kMaxLine = 96;   // longest possible line is 89 characters
+    size_t used = out.size();
+    out.resize(used + block.count * kMaxLine);
+    char* p = &out[used];
+    for (uint32_t i = 0; i < block.count; ++i) {
+        const Sample& s = block.samples[i];
+        char* end = p + kMaxLine;
+        p = std::copy_n("sensor=", 7, p);
+        p = std::to_chars(p, end, s.sensorId).ptr;
+        p = std::copy_n(" t=", 3, p);
+        p = std::to_chars(p, end, s.timestampNs).ptr;
+        p = std::copy_n(" value=", 7, p);
+        p = std::to_chars(p, end, s.value).ptr;
+        p = std::copy_n(" flags=", 7, p);
+        p = std::to_chars(p, end, s.flags).ptr;
+        *p++ = '\n';
+    }
+    out.resize(p - out.data());
+}
+
+} // namespace ingest
+
+#endif // SAMPLE_INGEST_H
@@ -0,0 +1,333 @@
+#ifndef TIME_SERIES_H
+#define TIME_SERIES_H
+
+// Fixed-memory, in-memory time-series store for sensor readings.
+//
+//     tsdb::TimeSeriesStore store;                          // default Config, see below
+//     store.add(sensorId, timestampNs, value);              // O(1) per sample
+//     tsdb::Aggregate last10s = store.window(sensorId, 0);  // rolling min/max/mean/stddev, no rescan
+//     tsdb::Aggregate lastHour = store.range(sensorId, now - hour, now);   // from downsampled tiers
+//
+// Per sensor there are three parts, all allocated when the sensor is first seen and never grown:
+//   raw:     ring of the last 'rawCapacity' (timestamp, value) points
+//   windows: rolling aggregates over the last N nanoseconds (before the newest sample). Mean and squared
+//            deviations are updated as samples enter and leave (Welford) and recomputed exactly from the raw
+//            ring after every 'rawCapacity' samples, so the rounding of the updates cannot pile up; min and
+//            max come from monotonic queues (the front is always the min / max, every sample is pushed and
+//            popped at most once). A window can hold at most 'rawCapacity' samples; older ones leave early.
+//   tiers:   downsampled buckets (default 1 s, 1 min, 1 h), each a ring of aggregates. range() picks the
+//            finest tier that still covers the start of the range with at most kMaxQueryBuckets buckets,
+//            so a query costs at most that many merges, whatever the raw sample rate.
+// range() works on whole buckets: the range is widened to the bucket edges of the tier it uses.
+//
+// Timestamps must be non-decreasing per sensor; late samples only go into the tiers.
+// Every sensor has its own mutex, so one thread can add while a dashboard thread queries.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace tsdb {
+
+const int64_t kSecond = 1000000000LL;
+const int64_t kMinute = 60 * kSecond;
+const int64_t kHour = 60 * kMinute;
+
+// Count, min, max, mean and the sum of squared deviations from the mean. Keeping the mean and the deviations
+// (Welford) instead of sum and sum of squares avoids the cancellation of sumSquares / n - mean^2 when the mean
+// is large compared with the spread.
+struct Aggregate {
+    uint64_t count = 0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+    double average = 0;
+    double m2 = 0;   // sum of (v - average)^2
+
+    void add(double v) {
+        ++count;
+        if (v < min) min = v;
+        if (v > max) max = v;
+        double d = v - average;
+        average += d / count;
+        m2 += d * (v - average);
+    }
+
+    // Chan et al.: the deviations of both parts plus the spread between their means.
+    void merge(const Aggregate& other) {
+        if (other.count == 0) return;
+        if (count == 0) {
+            *this = other;
+            return;
+        }
+        uint64_t n = count + other.count;
+        double d = other.average - average;
+        average += d * other.count / n;
+        m2 += other.m2 + d * d * ((double)count * other.count / n);
+        count = n;
+        if (other.min < min) min = other.min;
+        if (other.max > max) max = other.max;
+    }
+
+    double sum() const { return average * count; }
+    double mean() const { return count ? average : 0; }
+    double stddev() const {   // population standard deviation
+        if (count < 2) return 0;
+        return std::sqrt(std::max(0.0, m2 / count));
+    }
+};
+
+struct TierConfig {
+    int64_t bucketWidth;   // ns
+    size_t buckets;        // retention = bucketWidth * buckets
+};
+
+struct Config {
+    size_t rawCapacity = 4096;
+    std::vector<int64_t> windows = {10 * kSecond, kMinute};
+    std::vector<TierConfig> tiers = {{kSecond, 3600}, {kMinute, 1440}, {kHour, 720}};   // 1 h, 1 day, 30 days
+};
+
+class Series {
+public:
+    static const size_t kMaxQueryBuckets = 1024;
+
+    explicit Series(const Config& config) : raw(config.rawCapacity) {
+        for (int64_t length : config.windows) windows.emplace_back(length, config.rawCapacity);
+        for (const TierConfig& t : config.tiers) tiers.emplace_back(t);
+    }
+
+    void add(int64_t t, double v) {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (Tier& tier : tiers) tier.add(t, v);
+        if (seen > 0 && t < raw[(seen - 1) % raw.size()].t) return;   // out of order: tiers only
+
+        for (Window& w : windows) {
+            if (w.start + raw.size() <= seen) evict(w);   // the ring is about to overwrite its oldest sample
+        }
+        raw[seen % raw.size()] = Point{t, v};
+        uint64_t seq = seen++;
+        for (Window& w : windows) {
+            uint64_t n = seen - w.start;
+            double d = v - w.average;
+            w.average += d / n;
+            w.m2 += d * (v - w.average);
+            w.minQueue.push(seq, [&](uint64_t back) { return value(back) >= v; });
+            w.maxQueue.push(seq, [&](uint64_t back) { return value(back) <= v; });
+            while (raw[w.start % raw.size()].t <= t - w.length) evict(w);
+            if (++w.updates >= raw.size()) recompute(w);
+        }
+    }
+
+    size_t windowCount() const { return windows.size(); }
+
+    // Aggregate of the samples within windows[i] nanoseconds before the newest sample.
+    Aggregate window(size_t i) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        const Window& w = windows.at(i);
+        Aggregate a;
+        a.count = seen - w.start;
+        if (a.count == 0) return a;
+        a.min = value(w.minQueue.front());
+        a.max = value(w.maxQueue.front());
+        a.average = w.average;
+        a.m2 = w.m2;
+        return a;
+    }
+
+    // Aggregate of [from, to), widened to whole buckets of the tier that answers it.
+    Aggregate range(int64_t from, int64_t to) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        Aggregate a;
+        if (tiers.empty() || to <= from) return a;
+        const Tier* chosen = &tiers.back();
+        for (const Tier& tier : tiers) {
+            if (tier.covers(from) && tier.bucketsBetween(from, to) <= kMaxQueryBuckets) {
+                chosen = &tier;
+                break;
+            }
+        }
+        chosen->forEach(from, to, [&a](int64_t, const Aggregate& b) { a.merge(b); });
+        return a;
+    }
+
+    // Calls f(bucketStart, aggregate) for every non-empty bucket of tier i in [from, to), e.g. to draw a chart.
+    template <typename F>
+    void buckets(size_t i, int64_t from, int64_t to, F f) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        tiers.at(i).forEach(from, to, f);
+    }
+
+    uint64_t samplesSeen() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return seen;
+    }
+
+private:
+    struct Point {
+        int64_t t;
+        double v;
+    };
+
+    // Fixed-capacity deque of sample sequence numbers, kept monotonic by push().
+    class MonotonicQueue {
+    public:
+        explicit MonotonicQueue(size_t capacity) : items(capacity) {}
+
+        template <typename DropBack>
+        void push(uint64_t seq, DropBack dropBack) {
+            while (tail != head && dropBack(items[(tail - 1) % items.size()])) --tail;
+            items[tail++ % items.size()] = seq;
+        }
+
+        void popFrontIf(uint64_t seq) {
+            if (head != tail && items[head % items.size()] == seq) ++head;
+        }
+
+        uint64_t front() const { return items[head % items.size()]; }
+
+    private:
+        std::vector<uint64_t> items;
+        uint64_t head = 0, tail = 0;
+    };
+
+    struct Window {
+        Window(int64_t length, size_t capacity) : length(length), minQueue(capacity), maxQueue(capacity) {}
+
+        int64_t length;
+        uint64_t start = 0;    // sequence number of the oldest sample in the window
+        double average = 0;    // of the samples in the window
+        double m2 = 0;         // sum of their squared deviations from 'average'
+        size_t updates = 0;    // samples added since the last recompute()
+        MonotonicQueue minQueue;
+        MonotonicQueue maxQueue;
+    };
+
+    struct Tier {
+        explicit Tier(const TierConfig& c) : width(c.bucketWidth), slots(c.buckets) {}
+
+        static int64_t indexOf(int64_t t, int64_t width) {   // floor division, also for negative t
+            return t >= 0 ? t / width : -((-t + width - 1) / width);
+        }
+
+        void add(int64_t t, double v) {
+            int64_t index = indexOf(t, width);
+            if (index > newest) newest = index;
+            if (index <= newest - (int64_t)slots.size()) return;   // older than the retention
+            Slot& s = slots[(size_t)(index % (int64_t)slots.size() + (int64_t)slots.size()) % slots.size()];
+            if (s.index != index) {
+                s.index = index;
+                s.aggregate = Aggregate();
+            }
+            s.aggregate.add(v);
+        }
+
+        bool covers(int64_t t) const { return indexOf(t, width) > newest - (int64_t)slots.size(); }
+
+        size_t bucketsBetween(int64_t from, int64_t to) const {
+            return (size_t)(indexOf(to - 1, width) - indexOf(from, width) + 1);
+        }
+
+        template <typename F>
+        void forEach(int64_t from, int64_t to, F f) const {
+            int64_t first = std::max(indexOf(from, width), newest - (int64_t)slots.size() + 1);
+            int64_t last = std::min(indexOf(to - 1, width), newest);
+            for (int64_t index = first; index <= last; ++index) {
+                const Slot& s = slots[(size_t)(index % (int64_t)slots.size() + (int64_t)slots.size()) % slots.size()];
+                if (s.index == index) f(index * width, s.aggregate);
+            }
+        }
+
+        struct Slot {
+            int64_t index = std::numeric_limits<int64_t>::min();
+            Aggregate aggregate;
+        };
+
+        int64_t width;
+        int64_t newest = std::numeric_limits<int64_t>::min() / 2;
+        std::vector<Slot> slots;
+    };
+
+    double value(uint64_t seq) const { return raw[seq % raw.size()].v; }
+
+    // Welford in reverse: takes the oldest sample out of the mean and the deviations.
+    void evict(Window& w) {
+        uint64_t n = seen - w.start - 1;   // samples left
+        double x = value(w.start);
+        if (n == 0) {
+            w.average = w.m2 = 0;
+        } else {
+            double d = x - w.average;
+            w.average -= d / n;
+            w.m2 = std::max(0.0, w.m2 - d * (x - w.average));
+        }
+        w.minQueue.popFrontIf(w.start);
+        w.maxQueue.popFrontIf(w.start);
+        ++w.start;
+    }
+
+    // Exact mean and deviations of the window from the raw ring (two passes), O(window size) once every
+    // 'rawCapacity' samples.
+    void recompute(Window& w) {
+        w.updates = 0;
+        uint64_t n = seen - w.start;
+        if (n == 0) return;
+        double sum = 0;
+        for (uint64_t seq = w.start; seq < seen; ++seq) sum += value(seq);
+        w.average = sum / n;
+        w.m2 = 0;
+        for (uint64_t seq = w.start; seq < seen; ++seq) w.m2 += (value(seq) - w.average) * (value(seq) - w.average);
+    }
+
+    mutable std::mutex mtx;
+    std::vector<Point> raw;
+    uint64_t seen = 0;       // samples stored in 'raw' so far (sequence number of the next one)
+    std::vector<Window> windows;
+    std::vector<Tier> tiers;
+};
+
+class TimeSeriesStore {
+public:
+    explicit TimeSeriesStore(Config config = Config()) : config(std::move(config)) {}
+
+    void add(uint32_t sensorId, int64_t timestampNs, double value) { series(sensorId).add(timestampNs, value); }
+
+    // Queries never create a series: an id that was never added gives an empty aggregate, so probing
+    // unknown ids costs no memory.
+    Aggregate window(uint32_t sensorId, size_t i) const {
+        const Series* s = find(sensorId);
+        return s ? s->window(i) : Aggregate();
+    }
+    Aggregate range(uint32_t sensorId, int64_t from, int64_t to) const {
+        const Series* s = find(sensorId);
+        return s ? s->range(from, to) : Aggregate();
+    }
+
+    // Creates the series (and allocates all its memory) the first time a sensor id is used.
+    Series& series(uint32_t sensorId) {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::unique_ptr<Series>& s = sensors[sensorId];
+        if (!s) s.reset(new Series(config));
+        return *s;
+    }
+
+    // The series of a sensor id that has been added, or nullptr.
+    const Series* find(uint32_t sensorId) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = sensors.find(sensorId);
+        return it == sensors.end() ? nullptr : it->second.get();
+    }
+
+private:
+    Config config;
+    mutable std::mutex mtx;
+    std::unordered_map<uint32_t, std::unique_ptr<Series>> sensors;
+};
+
+} // namespace tsdb
+
+#endif // TIME_SERIES_H
@@ -0,0 +1,218 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Low-overhead tracing spans with Chrome / Perfetto trace export.
+//
+//     TRACE_THREAD_NAME("sensor");
+//     { TRACE_SCOPE("SafeQueue::push"); ... }          // complete span: begin + end timestamp
+//     TRACE_ASYNC_BEGIN("sample", id);                 // a span that starts on one thread...
+//     TRACE_ASYNC_END("sample", id);                   // ...and ends on another (end-to-end latency)
+//     trace::writeChromeJson("trace.json");            // open in chrome://tracing or ui.perfetto.dev
+//
+// Every thread records into its own fixed-size buffer. Only that thread writes to it, and it publishes each event
+// with a release store of the event count, so recording takes no lock. When a buffer is full, further events of
+// that thread are dropped and counted. The export reads the published events of all threads.
+//
+// Build with -DTRACE_ENABLED=0 and all TRACE_* macros expand to nothing.
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+#if TRACE_ENABLED
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace trace {
+
+enum class EventType : uint8_t { Complete, AsyncBegin, AsyncEnd };
+
+struct Event {
+    const char* name;   // must be a string literal (only the pointer is stored)
+    uint64_t start;     // ns
+    uint64_t end;       // ns (Complete only)
+    uint64_t id;        // async id (AsyncBegin / AsyncEnd only)
+    EventType type;
+};
+
+inline uint64_t now() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class ThreadBuffer {
+public:
+    static const size_t kCapacity = 1 << 16;   // events per thread
+
+    explicit ThreadBuffer(uint32_t tid) : tid(tid), events(new Event[kCapacity]) {}
+
+    void record(const Event& e) {
+        size_t n = count.load(std::memory_order_relaxed);
+        if (n == kCapacity) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        events[n] = e;
+        count.store(n + 1, std::memory_order_release);   // publish to the exporter
+    }
+
+    const uint32_t tid;
+    std::atomic<const char*> threadName{nullptr};   // string literal set by TRACE_THREAD_NAME
+    std::unique_ptr<Event[]> events;
+    std::atomic<size_t> count{0};
+    std::atomic<size_t> dropped{0};
+};
+
+class Registry {
+public:
+    static Registry& instance() {
+        static Registry registry;
+        return registry;
+    }
+
+    // Buffers are owned by the registry, so events survive after their thread has exited.
+    ThreadBuffer* newBuffer() {
+        std::lock_guard<std::mutex> lock(mtx);
+        buffers.push_back(std::unique_ptr<ThreadBuffer>(new ThreadBuffer((uint32_t)buffers.size() + 1)));
+        return buffers.back().get();
+    }
+
+    template <typename F>
+    void forEachBuffer(F f) {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (auto& b : buffers) f(*b);
+    }
+
+    const uint64_t origin = now();   // timestamps in the export are relative to this
+
+private:
+    std::mutex mtx;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+
+inline ThreadBuffer& threadBuffer() {
+    static thread_local ThreadBuffer* buffer = Registry::instance().newBuffer();
+    return *buffer;
+}
+
+inline void setThreadName(const char* name) {
+    threadBuffer().threadName.store(name, std::memory_order_release);
+}
+
+inline void asyncBegin(const char* name, uint64_t id) {
+    threadBuffer().record(Event{name, now(), 0, id, EventType::AsyncBegin});
+}
+
+inline void asyncEnd(const char* name, uint64_t id) {
+    threadBuffer().record(Event{name, now(), 0, id, EventType::AsyncEnd});
+}
+
+class ScopedSpan {
+public:
+    explicit ScopedSpan(const char* name) : name(name), start(now()) {}
+    ~ScopedSpan() { threadBuffer().record(Event{name, start, now(), 0, EventType::Complete}); }
+
+    ScopedSpan(const ScopedSpan&) = delete;
+    ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+private:
+    const char* name;
+    uint64_t start;
+};
+
+inline void writeJsonString(std::ostream& out, const std::string& s) {
+    out << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if ((unsigned char)c < 0x20) out << ' ';
+        else out << c;
+    }
+    out << '"';
+}
+
+// Writes the Chrome trace event format (JSON array of events, timestamps in microseconds).
+// Safe to call while other threads are still tracing: only events published so far are written.
+inline bool writeChromeJson(const std::string& filename) {
+    std::ofstream out(filename);
+    if (!out) return false;
+    Registry& registry = Registry::instance();
+    const uint64_t origin = registry.origin;
+    auto us = [origin](uint64_t ns) { return (double)(ns - origin) / 1000.0; };
+
+    out << "[\n";
+    bool first = true;
+    auto separator = [&] {
+        if (!first) out << ",\n";
+        first = false;
+    };
+    out.precision(3);
+    out << std::fixed;
+
+    registry.forEachBuffer([&](ThreadBuffer& b) {
+        size_t n = b.count.load(std::memory_order_acquire);
+        if (const char* threadName = b.threadName.load(std::memory_order_acquire)) {
+            separator();
+            out << R"({"ph":"M","name":"thread_name","pid":1,"tid":)" << b.tid << R"(,"args":{"name":)";
+            writeJsonString(out, threadName);
+            out << "}}";
+        }
+        for (size_t i = 0; i < n; ++i) {
+            const Event& e = b.events[i];
+            separator();
+            out << R"({"name":)";
+            writeJsonString(out, e.name);
+            out << R"(,"pid":1,"tid":)" << b.tid << R"(,"ts":)" << us(e.start);
+            switch (e.type) {
+            case EventType::Complete:
+                out << R"(,"ph":"X","dur":)" << (double)(e.end - e.start) / 1000.0;
+                break;
+            case EventType::AsyncBegin:
+                out << R"(,"ph":"b","cat":"async","id":)" << e.id;
+                break;
+            case EventType::AsyncEnd:
+                out << R"(,"ph":"e","cat":"async","id":)" << e.id;
+                break;
+            }
+            out << "}";
+        }
+        size_t dropped = b.dropped.load(std::memory_order_relaxed);
+        if (dropped) {
+            separator();
+            out << R"({"ph":"i","s":"t","name":"trace buffer full","pid":1,"tid":)" << b.tid
+                << R"(,"ts":)" << us(n ? b.events[n - 1].start : origin) << R"(,"args":{"dropped":)" << dropped << "}}";
+        }
+    });
+    out << "\n]\n";
+    return (bool)out;
+}
+
+} // namespace trace
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) ::trace::ScopedSpan TRACE_CONCAT(traceSpan_, __LINE__)(name)
+#define TRACE_ASYNC_BEGIN(name, id) ::trace::asyncBegin(name, id)
+#define TRACE_ASYNC_END(name, id) ::trace::asyncEnd(name, id)
+#define TRACE_THREAD_NAME(name) ::trace::setThreadName(name)
+#define TRACE_WRITE_JSON(filename) ::trace::writeChromeJson(filename)
+
+#else // TRACE_ENABLED
+
+// sizeof() keeps the arguments "used" (no warnings) without ever evaluating them.
+#define TRACE_SCOPE(name) do { (void)sizeof(name); } while (0)
+#define TRACE_ASYNC_BEGIN(name, id) do { (void)sizeof(name); (void)sizeof(id); } while (0)
+#define TRACE_ASYNC_END(name, id) do { (void)sizeof(name); (void)sizeof(id); } while (0)
+#define TRACE_THREAD_NAME(name) do { (void)sizeof(name); } while (0)
+#define TRACE_WRITE_JSON(filename) ((void)sizeof(filename), false)
+
+#endif // TRACE_ENABLED
+
+#endif // TRACE_H
@@ -0,0 +1,117 @@
+// Keep a history of the sensor readings instead of printing and forgetting them (challeng6_2.cpp).
+// Four simulated sensors at 100 Hz feed a TimeSeriesStore (TimeSeries.h) for two simulated hours.
+// The dashboard questions "last 10 s / last minute" and "last 5 min / last hour / whole run" are then
+// answered from the rolling windows and the downsampled tiers, and checked against a rescan of all raw samples.
+//     g++ -std=c++17 -O2 challeng6_10.cpp -o challeng6_10
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include "TimeSeries.h"
+
+using namespace std;
+
+const int kSensors = 4;
+const int64_t kPeriod = tsdb::kSecond / 100;   // 100 Hz
+const int64_t kDuration = 2 * tsdb::kHour;
+
+struct Reading {
+    uint32_t sensorId;
+    int64_t t;
+    double value;
+};
+
+// What the dashboards do today: keep every raw reading and scan them for every question.
+tsdb::Aggregate rescan(const vector<Reading>& log, uint32_t sensorId, int64_t from, int64_t to) {
+    tsdb::Aggregate a;
+    for (const Reading& r : log) {
+        if (r.sensorId == sensorId && r.t >= from && r.t < to) a.add(r.value);
+    }
+    return a;
+}
+
+void print(const char* name, const tsdb::Aggregate& a) {
+    cout << "  " << name << ": n=" << a.count << " min=" << a.min << " max=" << a.max
+         << " mean=" << a.mean() << " stddev=" << a.stddev() << endl;
+}
+
+template <typename F>
+double milliseconds(F f) {
+    auto start = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+    tsdb::Config config;
+    config.rawCapacity = 8192;   // the 1 minute window needs 6000 samples at 100 Hz
+    tsdb::TimeSeriesStore store(config);
+    vector<Reading> log;   // only kept here to check the store's answers
+    log.reserve((size_t)(kDuration / kPeriod) * kSensors);
+
+    mt19937 rng(5);
+    normal_distribution<double> noise(0.0, 0.5);
+    double ingestMs = milliseconds([&] {
+        for (int64_t t = 0; t < kDuration; t += kPeriod) {
+            for (uint32_t id = 0; id < kSensors; ++id) {
+                // A slow daily-like drift plus noise, different per sensor.
+                double value = 20 + id + 5 * sin((double)t / tsdb::kHour) + noise(rng);
+                store.add(id, t, value);
+                log.push_back(Reading{id, t, value});
+            }
+        }
+    });
+    cout << log.size() << " readings stored in " << ingestMs << " ms ("
+         << ingestMs * 1e6 / log.size() << " ns per reading)" << endl;
+
+    const uint32_t sensor = 2;
+    const int64_t now = kDuration;   // just after the last reading
+
+    cout << "\nSensor " << sensor << ", rolling windows (no rescan):" << endl;
+    print("last 10 s  ", store.window(sensor, 0));
+    print("rescan     ", rescan(log, sensor, now - 10 * tsdb::kSecond, now));
+    print("last minute", store.window(sensor, 1));
+    print("rescan     ", rescan(log, sensor, now - tsdb::kMinute, now));
+
+    struct Query {
+        const char* name;
+        int64_t from;
+    };
+    const Query queries[] = {{"last 5 min ", now - 5 * tsdb::kMinute}, {"last hour  ", now - tsdb::kHour},
+                             {"whole run  ", 0}};
+
+    cout << "\nSensor " << sensor << ", range queries from the tiers vs rescanning the raw log:" << endl;
+    for (const Query& q : queries) {
+        tsdb::Aggregate fromTiers, fromLog;
+        double tierMs = milliseconds([&] { fromTiers = store.range(sensor, q.from, now); });
+        double scanMs = milliseconds([&] { fromLog = rescan(log, sensor, q.from, now); });
+        print(q.name, fromTiers);
+        cout << "               tiers " << tierMs << " ms, rescan " << scanMs << " ms, mean differs by "
+             << fabs(fromTiers.mean() - fromLog.mean()) << endl;
+    }
+
+    cout << "\nSensor " << sensor << ", per-minute chart of the last 10 minutes (1 min tier):" << endl;
+    store.find(sensor)->buckets(1, now - 10 * tsdb::kMinute, now, [](int64_t start, const tsdb::Aggregate& a) {
+        cout << "  t=" << start / tsdb::kMinute << " min  mean " << a.mean() << "  [" << a.min << ", " << a.max << "]" << endl;
+    });
+
+    return 0;
+}
+
+
+/*Rolling windows and tiers:
+
+1. Every aggregate is updated as samples arrive, so a question costs the same whether the sensor produced
+   ten samples or ten million: the window keeps a running mean, and min/max come from monotonic queues
+   (a new sample removes every older sample that can never be the min/max again).
+2. Memory is fixed per sensor: a raw ring, the window queues and one ring of buckets per tier. The raw log
+   in this program grows without bound, which is exactly what the dashboards suffer from.
+3. The tiers are exact for count, min, max and mean of whole buckets. A range query is widened to the bucket
+   edges, so the "last hour" answer may include up to one extra bucket of the chosen tier.
+4. Standard deviation from sums of squares loses precision when the mean is large compared with the spread,
+   so every aggregate keeps the mean and the squared deviations from it (Welford), and tier buckets are
+   merged with the formula for combining two such parts. The rolling windows also take samples out again;
+   that rounding would slowly add up, so they are recomputed exactly from the raw ring now and then.
+*/
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include "Logger/LogLevel.h"
  
  using namespace std;
 
@@ -32,9 +33,17 @@ private:
     ofstream logFile_;
 };
 
+LOG_MODULE(mainLog, "main", LogLevel::Info);   // runtime threshold for this file
+
 int main() {
     Logger logger("log.txt");
     logger.log("This is a log message.");
+
+    LOG_INFO(logger, mainLog, "Logger started, writing to ", "log.txt");
+    LOG_DEBUG(logger, mainLog, "filtered at runtime: below the Info threshold of mainLog");
+    mainLog.setLevel(LogLevel::Debug);
+    LOG_DEBUG(logger, mainLog, "now enabled, value = ", 42);
+    LOG_TRACE(logger, mainLog, "compiled out entirely with -DLOG_COMPILE_LEVEL=LOG_LEVEL_INFO");
     return 0;
 }
 
@@ -45,7 +54,11 @@ int main() {
 2.The log method checks if the file is open before attempting to write to it. If the file is not open, it prints an error message.
 3.After writing to the file, the log method checks if the write operation was successful. If not, it prints an error message.
 
-This approach avoids using exceptions and simplifies error handling by directly checking the stream's state and using std::cerr to report errors.*/
+This approach avoids using exceptions and simplifies error handling by directly checking the stream's state and using std::cerr to report errors.
+
+4. The LOG_INFO / LOG_DEBUG / LOG_TRACE macros from Logger/LogLevel.h add severity levels on top of log():
+   a call below LOG_COMPILE_LEVEL is removed by the preprocessor (its arguments are never evaluated), and a call
+   below the module's runtime threshold costs one atomic load before the message is even formatted.*/
 
 
 /*The use of an underscore (_) at the end of a variable name, like logFile_,
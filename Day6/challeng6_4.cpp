@@ -0,0 +1,82 @@
+
+// Replace the mutex-based SafeQueue from challeng6_2.cpp with a bounded lock-free queue (BoundedSafeQueue.h).
+// Several sensor threads push readings, one logging thread drains them in batches.
+
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include "BoundedSafeQueue.h"
+
+using namespace std;
+
+const int kSensors = 4;
+const int kReadingsPerSensor = 1000000;
+
+// Simulate a sensor that produces readings as fast as it can, in small batches.
+void sensorReadingThread(BoundedSafeQueue<int> &queue, int sensorId) {
+    int batch[32];
+    for (int i = 0; i < kReadingsPerSensor; i += 32) {
+        for (int j = 0; j < 32; ++j) {
+            batch[j] = sensorId * kReadingsPerSensor + i + j;
+        }
+        queue.push_batch(batch, 32);   // Blocks (after spinning) if the logger falls behind; memory stays bounded.
+    }
+}
+
+// Drain the queue in batches of up to 256 readings.
+void loggingThread(BoundedSafeQueue<int> &queue, long long &sum) {
+    int batch[256];
+    long long received = 0;
+    while (received < (long long)kSensors * kReadingsPerSensor) {
+        size_t n = queue.pop_batch(batch, 256);
+        for (size_t i = 0; i < n; ++i) {
+            sum += batch[i];
+        }
+        received += n;
+    }
+}
+
+int main() {
+    BoundedSafeQueue<int> queue(4096);   // Fixed capacity instead of an unbounded std::queue.
+    long long sum = 0;
+
+    auto start = chrono::steady_clock::now();
+
+    thread logThread(loggingThread, ref(queue), ref(sum));
+    vector<thread> sensors;
+    for (int id = 0; id < kSensors; ++id) {
+        sensors.emplace_back(sensorReadingThread, ref(queue), id);
+    }
+
+    for (auto &t : sensors) t.join();
+    logThread.join();
+
+    auto elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    long long total = (long long)kSensors * kReadingsPerSensor;
+    long long expected = total * (total - 1) / 2;
+
+    cout << "Received " << total << " readings in " << elapsed << " s ("
+         << total / elapsed / 1e6 << " M items/s)" << endl;
+    cout << (sum == expected ? "Checksum OK" : "Checksum MISMATCH") << endl;
+
+    // The single-item API is the same as SafeQueue's.
+    queue.push(42);
+    int value;
+    if (queue.try_pop(value)) {
+        cout << "try_pop: " << value << endl;
+    }
+
+    return 0;
+}
+
+
+/*BoundedSafeQueue vs SafeQueue:
+
+1. Fixed capacity: the ring buffer is allocated once. When the consumer falls behind, producers wait
+   instead of growing the queue without limit.
+2. No lock on the fast path: each slot has a sequence number. A producer claims a slot with one CAS on the
+   enqueue index and publishes it by storing the next sequence number; a consumer does the same on the dequeue index.
+3. Spin, then block: pop() retries try_pop() a few hundred times before sleeping on a condition variable,
+   and push()/try_push() only take the mutex to notify when a consumer is actually asleep.
+4. Batches: push_batch()/pop_batch() claim a whole run of consecutive slots with a single CAS.*/
@@ -0,0 +1,81 @@
+
+// Same program as challeng6_1.cpp, but DataLogger writes binary records (RecordLog.h) to a file it keeps open,
+// and readData() memory-maps the file instead of parsing it back line by line.
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include "RecordLog.h"
+
+using namespace std;
+using namespace recordlog;
+
+class DataLogger {
+public:
+    DataLogger(const string &filename) : filename(filename), writer(filename) {}
+
+    // One record per call: timestamp + producer id + the ints as raw bytes. No open/close, no text conversion.
+    void logData(uint16_t producerId, const vector<int> &data) {
+        writer.write(producerId, data.data(), (uint32_t)(data.size() * sizeof(int)));
+    }
+
+    void readData() {
+        writer.flush();                 // Make sure everything we buffered is in the file.
+        RecordReader reader(filename);  // Maps the file; records are read in place.
+        for (RecordView record : reader) {
+            cout << "producer " << record.producerId << ":";
+            const int *values = record.as<int>();
+            for (size_t i = 0; i < record.count<int>(); ++i) {
+                cout << " " << values[i];
+            }
+            cout << endl;
+        }
+
+        // Random access through the sparse index.
+        if (reader.count() > 0) {
+            RecordView last = reader.at(reader.count() - 1);
+            cout << reader.count() << " records, last one from producer " << last.producerId << endl;
+        }
+    }
+
+private:
+    string filename;
+    RecordWriter writer;  // Keeps the file open for the lifetime of the logger.
+};
+
+void generateData(DataLogger &logger, int start) {
+    for (int i = 0; i < 5; ++i) {
+        vector<int> data = {start + i, start + i + 1, start + i + 2};
+        logger.logData((uint16_t)start, data);
+        this_thread::sleep_for(chrono::milliseconds(100));
+    }
+}
+
+int main() {
+    remove("data_log.bin");
+    DataLogger logger("data_log.bin");
+
+    thread t1(generateData, ref(logger), 100);
+    thread t2(generateData, ref(logger), 200);
+
+    t1.join();
+    t2.join();
+
+    logger.readData();
+
+    return 0;
+}
+
+
+/*Record format (see RecordLog.h):
+
+File header: 16 bytes, magic "DLOG" + version.
+Every record: [length u32][producer id u16][reserved u16][timestamp ns u64][payload ... padded to 8 bytes]
+
+1. Length-prefixed: the reader jumps from record to record using only the headers, it never scans the payload.
+2. Append-only: the writer opens the file once with O_APPEND and writes whole buffers, not single values.
+3. mmap: RecordReader maps the file, so a RecordView is just a pointer into the mapping (zero-copy).
+4. Sparse index: every 1024th record offset is remembered, so reader.at(i) skips at most 1023 headers.
+5. A record that was only half written (for example after a crash) is ignored instead of being parsed as garbage.*/
@@ -0,0 +1,93 @@
+
+// Read a large sensor export with CsvEngine.h and compare it with the line-by-line readCSV from csvfile.rtl.md.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include "CsvEngine.h"
+
+using namespace std;
+
+struct Record {
+    int id;
+    string name;
+    double value;
+};
+
+// The original approach: getline + istringstream + stoi for every field.
+vector<Record> readCSVLineByLine(const string &filename) {
+    vector<Record> records;
+    ifstream file(filename);
+    string line;
+    getline(file, line);   // header
+    while (getline(file, line)) {
+        istringstream ss(line);
+        string token;
+        Record record;
+        getline(ss, token, ',');
+        record.id = stoi(token);
+        getline(ss, token, ',');
+        record.name = token;
+        getline(ss, token, ',');
+        record.value = stod(token);
+        records.push_back(record);
+    }
+    return records;
+}
+
+void writeSensorExport(const string &filename, int rows) {
+    ofstream file(filename);
+    file << "id,name,value\n";
+    for (int i = 0; i < rows; ++i) {
+        file << i << ",sensor_" << (i % 100) << ',' << (i % 1000) * 0.25 << '\n';
+    }
+}
+
+int main() {
+    const string filename = "sensors.csv";
+    const int rows = 2000000;
+    writeSensorExport(filename, rows);
+
+    auto t0 = chrono::steady_clock::now();
+    vector<Record> records = readCSVLineByLine(filename);
+    auto t1 = chrono::steady_clock::now();
+
+    // id, name, value -> one vector per column; names are string_views into the mapped file.
+    csv::Table table = csv::readCSV(filename, {csv::ColumnType::Int64, csv::ColumnType::String, csv::ColumnType::Double});
+    auto t2 = chrono::steady_clock::now();
+
+    double sum = 0;
+    for (double v : table.doubles(2)) sum += v;
+
+    cout << "getline/istringstream: " << records.size() << " rows in "
+         << chrono::duration<double, milli>(t1 - t0).count() << " ms" << endl;
+    cout << "CsvEngine:             " << table.rows << " rows in "
+         << chrono::duration<double, milli>(t2 - t1).count() << " ms" << endl;
+    cout << "Columns: " << table.names[0] << ", " << table.names[1] << ", " << table.names[2] << endl;
+    cout << "Sum of values: " << sum << endl;
+
+    // Quoted fields: commas, newlines and doubled quotes inside "..." (the getline version cannot handle these).
+    csv::Table quoted = csv::parse("id,name\n1,\"Hall, \"\"north\"\" wing\"\n", {csv::ColumnType::Int64, csv::ColumnType::String});
+    cout << "Quoted field: " << quoted.strings(1)[0] << endl;
+
+    // Lenient mode: broken rows are repaired and counted instead of throwing.
+    csv::Options lenient;
+    lenient.errorMode = csv::ErrorMode::Lenient;
+    csv::Table broken = csv::parse("id,value\n1,2.5\n2,abc\n3\n", {csv::ColumnType::Int64, csv::ColumnType::Double}, lenient);
+    cout << "Lenient parse: " << broken.rows << " rows, " << broken.errors << " repaired" << endl;
+
+    remove(filename.c_str());
+    return 0;
+}
+
+
+/*Why CsvEngine is faster:
+
+1. mmap instead of ifstream + getline: the file is not copied into a std::string per line.
+2. SIMD scanning: 16 bytes are compared against ',', '\n' and '"' in one instruction (SSE2).
+3. Parallel chunks: the file is split at row boundaries (quote-aware) and every core parses its own chunk.
+4. from_chars instead of stoi/stod: no locale, no exceptions, no temporary strings.
+5. Columnar result: all values of one column are contiguous, which is what aggregations want.*/
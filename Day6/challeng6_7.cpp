@@ -0,0 +1,121 @@
+
+// The sensor -> SafeQueue -> Logger pipeline from challeng6_2.cpp and the Task classes from Day5/challeng5_2.cpp,
+// instrumented with Trace.h. The program writes trace.json; open it in chrome://tracing or https://ui.perfetto.dev
+// to see queue wait time, lock hold time and the end-to-end latency of every sample.
+// Compile with -DTRACE_ENABLED=0 to remove all tracing.
+
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <utility>
+#include "Trace.h"
+#define SAFE_QUEUE_SCOPE(name) TRACE_SCOPE(name)
+#include "SafeQueue.h"
+
+using namespace std;
+
+const int kSamples = 200;
+
+class Logger {
+public:
+    void log(const string &message) {
+        TRACE_SCOPE("Logger::log");
+        lock_guard<mutex> lock(log_mtx);
+        TRACE_SCOPE("Logger::log lock held");
+        cout << "Logged: " << message << "\n";
+    }
+
+private:
+    mutex log_mtx;
+};
+
+struct Sample {
+    int id;
+    string text;
+};
+
+void sensorReadingThread(SafeQueue<Sample> &queue) {
+    TRACE_THREAD_NAME("sensor");
+    for (int sensorValue = 1; sensorValue <= kSamples; ++sensorValue) {
+        this_thread::sleep_for(chrono::milliseconds(2));
+        TRACE_ASYNC_BEGIN("sample latency", sensorValue);   // ends when the logger has written it
+        TRACE_SCOPE("read sensor");
+        queue.push(Sample{sensorValue, "Sensor value: " + to_string(sensorValue)});
+    }
+}
+
+void loggingThread(SafeQueue<Sample> &queue, Logger &logger) {
+    TRACE_THREAD_NAME("logger");
+    Sample sample;
+    for (int i = 0; i < kSamples; ++i) {
+        if (queue.pop(sample)) {
+            logger.log(sample.text);
+            TRACE_ASYNC_END("sample latency", sample.id);
+        }
+    }
+}
+
+// Task classes from Day5/challeng5_2.cpp with a span around execute().
+class Task {
+public:
+    virtual void execute() = 0;
+    virtual ~Task() = default;
+};
+
+class PrintTask : public Task {
+public:
+    void execute() override {
+        TRACE_SCOPE("PrintTask::execute");
+        for (int i = 0; i < 10; ++i) cout << "PrintTask: " + to_string(i) + "\n";
+    }
+};
+
+class ComputeTask : public Task {
+public:
+    void execute() override {
+        TRACE_SCOPE("ComputeTask::execute");
+        long long sum = 0;
+        for (int i = 1; i <= 1000000; ++i) sum += i;
+        cout << "ComputeTask: sum = " + to_string(sum) + "\n";
+    }
+};
+
+void runTask(Task *task, const char *threadName) {
+    TRACE_THREAD_NAME(threadName);
+    task->execute();
+}
+
+int main() {
+    TRACE_THREAD_NAME("main");
+
+    SafeQueue<Sample> queue;
+    Logger logger;
+    thread sensorThread(sensorReadingThread, ref(queue));
+    thread logThread(loggingThread, ref(queue), ref(logger));
+
+    PrintTask printTask;
+    ComputeTask computeTask;
+    thread printThread(runTask, &printTask, "PrintTask");
+    thread computeThread(runTask, &computeTask, "ComputeTask");
+
+    sensorThread.join();
+    logThread.join();
+    printThread.join();
+    computeThread.join();
+
+    if (TRACE_WRITE_JSON("trace.json")) {
+        cout << "Trace written to trace.json" << endl;
+    }
+    return 0;
+}
+
+
+/*What the trace shows:
+
+- "SafeQueue::pop wait": how long the logger sat in cv.wait() for the next sample (queue wait time).
+- "... lock held": how long each mutex was held, nested inside the span of the whole call.
+- "sample latency": an async span from the moment a sample was read to the moment it was logged,
+  drawn across the sensor and logger threads (end-to-end latency).
+- Every thread records into its own buffer without locks; writeChromeJson() merges them at the end.*/
@@ -0,0 +1,252 @@
+// Benchmark suite for the classes of the course, so changes can be measured before and after:
+//   - SafeQueue (challeng6_2.cpp): throughput and per-item latency with 1..N producers and consumers
+//   - Logger::log (Logger/) in sync and async mode, and DataLogger::logData (challeng6_1.cpp): lines per second
+//   - Shape::area (Day4) over a large array, next to ShapeBatch for reference
+//   - findMax / Max (Day5/challeng5_1.cpp)
+//
+// Build with optimisations, otherwise the numbers say nothing:
+//     g++ -std=c++17 -O2 -pthread challeng6_8.cpp Logger/logger.cpp -o bench
+//     (or: cmake -S . -B build && cmake --build build --target bench, with CMakeLists.txt in this directory)
+//     ./bench --json before.json
+//     ... change something ...
+//     ./bench --json after.json --compare before.json
+// See Bench.h for the other options (--runs, --warmup, --filter).
+
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include "Bench.h"
+#include "SafeQueue.h"
+#include "Logger/Logger.h"
+#include "../Day4/Shape.h"
+#include "../Day4/ShapeBatch.h"
+
+using namespace std;
+
+// ---- Code under test (copied unchanged from the exercises, except where noted) ----
+
+mutex logMutex;
+
+class DataLogger {
+public:
+    DataLogger(const string &filename) : filename(filename) {}
+
+    void logData(const vector<int> &data) {
+        std::lock_guard<mutex> guard(logMutex);
+        std::ofstream outFile(filename, ios::app);
+        if (outFile.is_open()) {
+            for (int value : data) {
+                outFile << value << endl;
+            }
+            outFile.close();
+        }
+    }
+
+private:
+    string filename;
+};
+
+template <typename T>
+T findMax(T a, T b) {
+    return (a > b) ? a : b;
+}
+
+// challeng5_1.cpp only has display(), which prints; value() returns the same result so it can be measured.
+template <typename T>
+class Max
+{
+private:
+    T x, y;
+
+public:
+    Max(T n, T m) : x(n), y(m) {}
+    T value() const { return (x > y) ? x : y; }
+};
+
+// ---- Benchmarks ----
+
+const char* kLogFile = "bench_log.txt";
+const char* kDataFile = "bench_data.txt";
+
+using Clock = chrono::steady_clock;
+
+struct Item {
+    Clock::time_point pushed;
+    bool last;   // tells one consumer to stop
+};
+
+// Moves 'total' items from 'producers' threads to 'consumers' threads through one SafeQueue.
+// When 'latencies' is given, every consumer records how long each item spent in the queue. Then at most
+// 'producers' items are in the queue at any time: a producer waits until one is taken before it pushes
+// the next, so the time measured is the hand-off itself, not the wait behind a backlog of queued items.
+void runQueue(int producers, int consumers, int total, vector<double>* latencies) {
+    SafeQueue<Item> queue;
+    atomic<int> inFlight{0};
+    vector<vector<double>> perConsumer(consumers);
+    vector<thread> threads;
+    for (int c = 0; c < consumers; ++c) {
+        threads.emplace_back([&, c] {
+            vector<double>& mine = perConsumer[c];
+            Item item;
+            while (queue.pop(item) && !item.last) {
+                if (latencies) {
+                    mine.push_back(chrono::duration<double, nano>(Clock::now() - item.pushed).count());
+                    inFlight.fetch_sub(1, memory_order_release);
+                }
+            }
+        });
+    }
+    vector<thread> producerThreads;
+    for (int p = 0; p < producers; ++p) {
+        int count = total / producers + (p < total % producers ? 1 : 0);
+        producerThreads.emplace_back([&queue, &inFlight, count, latencies, producers] {
+            for (int i = 0; i < count; ++i) {
+                if (latencies) {
+                    while (inFlight.fetch_add(1, memory_order_acquire) >= producers) {
+                        inFlight.fetch_sub(1, memory_order_relaxed);
+                        this_thread::yield();
+                    }
+                }
+                queue.push(Item{latencies ? Clock::now() : Clock::time_point(), false});
+            }
+        });
+    }
+    for (auto& t : producerThreads) t.join();
+    for (int c = 0; c < consumers; ++c) queue.push(Item{Clock::time_point(), true});
+    for (auto& t : threads) t.join();
+    if (latencies) {
+        for (auto& v : perConsumer) latencies->insert(latencies->end(), v.begin(), v.end());
+    }
+}
+
+void benchQueue(bench::Suite& suite) {
+    const int kItems = 200000;
+    int maxThreads = (int)max(2u, min(4u, thread::hardware_concurrency()));
+    for (int producers = 1; producers <= maxThreads; producers *= 2) {
+        for (int consumers = 1; consumers <= maxThreads; consumers *= 2) {
+            string config = to_string(producers) + "P/" + to_string(consumers) + "C";
+            suite.throughput("SafeQueue " + config + " throughput", "items/s", kItems,
+                             [=] { runQueue(producers, consumers, kItems, nullptr); });
+
+            string latencyName = "SafeQueue " + config + " latency";
+            if (suite.enabled(latencyName)) {
+                vector<double> latencies;
+                runQueue(producers, consumers, kItems / 4, nullptr);   // warm-up
+                runQueue(producers, consumers, kItems / 4, &latencies);
+                suite.latency(latencyName, latencies);
+            }
+        }
+    }
+}
+
+void benchLoggers(bench::Suite& suite) {
+    const int kLines = 20000;
+    remove(kLogFile);
+    {
+        Logger logger(kLogFile, Logger::Mode::Sync);
+        suite.throughput("Logger::log sync", "lines/s", kLines, [&] {
+            for (int i = 0; i < kLines; ++i) logger.log("Count: " + to_string(i));
+        });
+    }
+    remove(kLogFile);
+    {
+        Logger logger(kLogFile, Logger::Mode::Async);
+        suite.throughput("Logger::log async (incl. flush)", "lines/s", kLines, [&] {
+            for (int i = 0; i < kLines; ++i) logger.log("Count: " + to_string(i));
+            logger.flush();
+        });
+    }
+    remove(kLogFile);
+
+    // logData opens and closes the file on every call, so far fewer calls are made per run.
+    const int kCalls = 500;
+    remove(kDataFile);
+    DataLogger dataLogger(kDataFile);
+    suite.throughput("DataLogger::logData (3 values/call)", "lines/s", kCalls * 3.0, [&] {
+        for (int i = 0; i < kCalls; ++i) dataLogger.logData({i, i + 1, i + 2});
+    });
+    remove(kDataFile);
+}
+
+void benchShapes(bench::Suite& suite) {
+    const int kShapes = 1000000;
+    mt19937 rng(42);
+    uniform_real_distribution<double> dim(0.5, 10.0);
+    vector<unique_ptr<Shape>> shapes;
+    ShapeBatch batch;
+    shapes.reserve(kShapes);
+    for (int i = 0; i < kShapes; ++i) {
+        if (rng() % 2) shapes.emplace_back(new Circle(dim(rng)));
+        else shapes.emplace_back(new Rectangle(dim(rng), dim(rng)));
+        batch.add(*shapes.back());
+    }
+
+    suite.timePerItem("Shape::area (virtual, 1M shapes)", kShapes, [&] {
+        double total = 0;
+        for (const auto& s : shapes) total += s->area();
+        bench::doNotOptimize(total);
+    });
+    suite.timePerItem("ShapeBatch::totalArea (1M shapes)", kShapes, [&] {
+        bench::doNotOptimize(batch.totalArea());
+    });
+}
+
+template <typename T>
+void benchMax(bench::Suite& suite, const string& type, const vector<T>& values) {
+    suite.timePerItem("findMax<" + type + "> reduction", values.size(), [&] {
+        T best = values[0];
+        for (const T& v : values) best = findMax(best, v);
+        bench::doNotOptimize(best);
+    });
+    suite.timePerItem("Max<" + type + ">::value reduction", values.size(), [&] {
+        T best = values[0];
+        for (const T& v : values) best = Max<T>(best, v).value();
+        bench::doNotOptimize(best);
+    });
+}
+
+int main(int argc, char** argv) {
+    bench::Suite suite("EmbededCourse", argc, argv);
+
+    benchQueue(suite);
+    benchLoggers(suite);
+    benchShapes(suite);
+
+    const size_t kValues = 1 << 20;
+    mt19937 rng(7);
+    vector<int> ints(kValues);
+    vector<double> doubles(kValues);
+    for (size_t i = 0; i < kValues; ++i) {
+        ints[i] = (int)rng();
+        doubles[i] = (double)rng() / rng.max();
+    }
+    benchMax(suite, "int", ints);
+    benchMax(suite, "double", doubles);
+
+    return suite.finish();
+}
+
+
+/*How to read the numbers:
+
+1. median: the typical run. Compare medians, not single runs; one run can hit a context switch or a cache miss storm.
+2. 95% CI: the range the true median lies in with 95% confidence. If the intervals of two builds overlap,
+   the difference may be noise. --compare only reports a regression when they do not overlap.
+3. tail: the slow end. For the SafeQueue latency it is the p99 over every single item, which is what a
+   real-time consumer cares about. Throughput has one sample per run, too few for a p99, so the slowest
+   run is shown ("worst").
+4. SafeQueue latency is measured with at most one item per producer in the queue, so it is the time from
+   push() to the consumer having the item. With an unbounded backlog it would be the time spent queueing.
+5. Throughput with more producers than cores mostly measures lock contention and context switches,
+   which is exactly the cost of the single mutex in SafeQueue.
+6. Logger sync calls endl (a flush) for every line; async only copies into a buffer. DataLogger opens and closes
+   the file on every call, which is why it is orders of magnitude slower.
+*/
@@ -0,0 +1,145 @@
+// The sensor -> queue -> logger pipeline of challeng6_2.cpp, twice:
+//   1. as in challeng6_2.cpp: every reading becomes a std::string that goes through SafeQueue<string>
+//   2. with SampleIngest.h: typed 24-byte samples written into pre-allocated blocks, only block pointers
+//      go through the queue, and text is made once per block at the logger
+// Both write the same number of readings from several sensor threads to a log file (async Logger) and
+// report the time and the number of heap allocations per reading.
+//     g++ -std=c++17 -O2 -pthread challeng6_9.cpp Logger/logger.cpp -o challeng6_9
+
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include "SampleIngest.h"
+#include "SafeQueue.h"
+#include "Logger/Logger.h"
+
+using namespace std;
+
+// Counts every heap allocation of the program.
+atomic<long> allocations{0};
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+const int kSensors = 4;
+const int kReadingsPerSensor = 250000;
+const long kReadings = (long)kSensors * kReadingsPerSensor;
+
+// ---- 1. String pipeline (challeng6_2.cpp) ----
+
+void stringSensor(SafeQueue<string> &queue, int sensorId) {
+    for (int i = 0; i < kReadingsPerSensor; ++i) {
+        int sensorValue = sensorId * kReadingsPerSensor + i;
+        queue.push("Sensor value: " + to_string(sensorValue));
+    }
+}
+
+void stringLogging(SafeQueue<string> &queue, Logger &logger) {
+    string data;
+    for (long n = 0; n < kReadings; ++n) {
+        if (queue.pop(data)) {
+            logger.log(data);
+        }
+    }
+}
+
+// ---- 2. Typed sample pipeline ----
+
+void sampleSensor(ingest::Ingest &channel, int sensorId) {
+    ingest::SampleWriter writer(channel);
+    for (int i = 0; i < kReadingsPerSensor; ++i) {
+        writer.write(sensorId, sensorId * kReadingsPerSensor + i);
+    }
+    writer.flush();
+}
+
+void sampleLogging(ingest::Ingest &channel, Logger &logger, long &received) {
+    string text;   // reused for every block
+    while (ingest::SampleBlock* block = channel.receive()) {
+        received += block->count;
+        text.clear();
+        ingest::appendText(*block, text);
+        channel.release(block);        // the block can be refilled while we write the text
+        text.pop_back();               // Logger::log adds the last '\n'
+        logger.log(text);
+    }
+}
+
+struct Result {
+    double seconds;
+    long allocations;
+};
+
+template <typename Run>
+Result measure(Run run) {
+    long before = allocations.load();
+    auto start = chrono::steady_clock::now();
+    run();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return Result{seconds, allocations.load() - before};
+}
+
+void report(const char* name, const Result& r) {
+    cout << name << ": " << r.seconds * 1000 << " ms, " << kReadings / r.seconds / 1e6 << " M readings/s, "
+         << (double)r.allocations / kReadings << " allocations per reading" << endl;
+}
+
+int main() {
+    remove("strings.log");
+    remove("samples.log");
+
+    Result strings = measure([] {
+        Logger logger("strings.log", Logger::Mode::Async);
+        SafeQueue<string> queue;
+        thread logThread(stringLogging, ref(queue), ref(logger));
+        vector<thread> sensors;
+        for (int id = 0; id < kSensors; ++id) sensors.emplace_back(stringSensor, ref(queue), id);
+        for (auto &t : sensors) t.join();
+        logThread.join();
+    });
+
+    long received = 0;
+    Result samples = measure([&received] {
+        Logger logger("samples.log", Logger::Mode::Async);
+        ingest::Ingest channel(64);   // 64 x 256 samples, allocated here once
+        thread logThread(sampleLogging, ref(channel), ref(logger), ref(received));
+        vector<thread> sensors;
+        for (int id = 0; id < kSensors; ++id) sensors.emplace_back(sampleSensor, ref(channel), id);
+        for (auto &t : sensors) t.join();
+        channel.close(1);
+        logThread.join();
+    });
+
+    cout << kReadings << " readings from " << kSensors << " sensors" << endl;
+    report("string per reading ", strings);
+    report("typed sample blocks", samples);
+    cout << (received == kReadings ? "All samples received" : "Samples LOST") << endl;
+
+    return 0;
+}
+
+
+/*Why the typed pipeline is cheaper:
+
+1. No allocation per reading: "Sensor value: " + to_string(v) allocates (the string is longer than the
+   small-string buffer), and std::queue allocates its nodes. A Sample is 24 bytes written into a block
+   that was allocated when the program started.
+2. One queue operation per 256 readings instead of one per reading, so the queue lock/CAS is paid once per block.
+3. Formatting happens once, at the output edge, with to_chars into a reused buffer, not on the sensor thread.
+4. Bounded memory: if the logger is slow, the sensors wait for a free block instead of filling the heap.
+5. The sample keeps its type: the consumer can filter by sensor id or flags, compute statistics or store
+   binary records (RecordLog.h) without parsing text back into numbers.
+*/
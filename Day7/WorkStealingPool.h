@@ -0,0 +1,294 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+// Work-stealing version of the ThreadPool from Thread_pool.rtl.md.
+//
+// Instead of one mutex-protected std::queue<std::function<void()>> that every worker fights over,
+// each worker owns its own deque:
+//   - the owner pushes and pops at the back (LIFO, so nested work stays hot in its cache),
+//   - idle workers steal from the front of a randomly chosen victim.
+// Each deque has its own small lock, which is almost never contended, so there is no global lock.
+// Jobs are stored in a Job object with inline storage, so small lambdas do not allocate like std::function does.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// A move-only "void()" callable with small-buffer storage.
+// Callables up to kInlineSize bytes are placement-constructed inside the Job; larger ones fall back to the heap.
+class Job {
+public:
+    static constexpr size_t kInlineSize = 64;
+
+    Job() = default;
+
+    template <typename F, typename Fn = typename std::decay<F>::type,
+              typename = typename std::enable_if<!std::is_same<Fn, Job>::value>::type>
+    Job(F&& f) {
+        if (sizeof(Fn) <= kInlineSize && alignof(Fn) <= alignof(std::max_align_t) &&
+            std::is_nothrow_move_constructible<Fn>::value) {
+            new (storage) Fn(std::forward<F>(f));
+            ops = &InlineOps<Fn>::table;
+        } else {
+            *reinterpret_cast<Fn**>(storage) = new Fn(std::forward<F>(f));
+            ops = &HeapOps<Fn>::table;
+        }
+    }
+
+    Job(Job&& other) noexcept : ops(other.ops) {
+        if (ops) {
+            ops->move(storage, other.storage);
+            other.ops = nullptr;
+        }
+    }
+
+    Job& operator=(Job&& other) noexcept {
+        if (this != &other) {
+            reset();
+            ops = other.ops;
+            if (ops) {
+                ops->move(storage, other.storage);
+                other.ops = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    Job(const Job&) = delete;
+    Job& operator=(const Job&) = delete;
+
+    ~Job() { reset(); }
+
+    explicit operator bool() const { return ops != nullptr; }
+    void operator()() { ops->invoke(storage); }
+
+private:
+    struct Ops {
+        void (*invoke)(void*);
+        void (*move)(void* dst, void* src);   // move-constructs into dst and destroys src
+        void (*destroy)(void*);
+    };
+
+    template <typename Fn>
+    struct InlineOps {
+        static void invoke(void* p) { (*static_cast<Fn*>(p))(); }
+        static void move(void* dst, void* src) {
+            new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        }
+        static void destroy(void* p) { static_cast<Fn*>(p)->~Fn(); }
+        static constexpr Ops table = {invoke, move, destroy};
+    };
+
+    template <typename Fn>
+    struct HeapOps {
+        static void invoke(void* p) { (**static_cast<Fn**>(p))(); }
+        static void move(void* dst, void* src) { *static_cast<Fn**>(dst) = *static_cast<Fn**>(src); }
+        static void destroy(void* p) { delete *static_cast<Fn**>(p); }
+        static constexpr Ops table = {invoke, move, destroy};
+    };
+
+    void reset() {
+        if (ops) {
+            ops->destroy(storage);
+            ops = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage[kInlineSize];
+    const Ops* ops = nullptr;
+};
+
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(size_t threads = std::thread::hardware_concurrency())
+        : queues(threads == 0 ? 1 : threads) {
+        for (size_t i = 0; i < queues.size(); ++i) {
+            workers.emplace_back(&WorkStealingPool::worker_thread, this, i);
+        }
+    }
+
+    // Runs every job that is still queued, then joins the workers.
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMtx);
+            stop = true;
+        }
+        wakeUp.notify_all();
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Schedules f and returns a future for its result. Safe to call from inside a running job (nested spawning):
+    // the child goes onto the calling worker's own deque.
+    template <typename F>
+    auto enqueue(F&& f) -> std::future<decltype(f())> {
+        using R = decltype(f());
+        std::promise<R> promise;
+        std::future<R> result = promise.get_future();
+        spawn([fn = typename std::decay<F>::type(std::forward<F>(f)), p = std::move(promise)]() mutable {
+            try {
+                setValue(p, fn);
+            } catch (...) {
+                p.set_exception(std::current_exception());
+            }
+        });
+        return result;
+    }
+
+    // Fire-and-forget version of enqueue(): no promise/future shared state is created.
+    // An exception thrown by f has nowhere to go: the worker catches it, reports it on stderr and counts it
+    // in failedJobs(), then carries on with the next job.
+    template <typename F>
+    void spawn(F&& f) {
+        size_t target = (currentPool == this) ? currentIndex
+                                              : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+        {
+            std::lock_guard<std::mutex> lock(queues[target].mtx);
+            queues[target].jobs.emplace_back(std::forward<F>(f));
+        }
+        pending.fetch_add(1, std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(sleepMtx);
+            wakeUp.notify_one();
+        }
+    }
+
+    // Waits for a future without blocking the worker: while the result is not ready, the calling thread
+    // runs other queued jobs. Use this instead of future.get() inside a job, or nested jobs can deadlock the pool.
+    template <typename R>
+    R wait(std::future<R>& future) {
+        while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            if (!runPendingJob()) {
+                std::this_thread::yield();
+            }
+        }
+        return future.get();
+    }
+
+    size_t size() const { return workers.size(); }
+
+    // spawn() jobs that ended with an exception (enqueue() hands those to the future instead).
+    uint64_t failedJobs() const { return failed.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(64) WorkerQueue {   // one per worker, on its own cache line
+        std::mutex mtx;
+        std::deque<Job> jobs;
+    };
+
+    template <typename R, typename Fn>
+    static void setValue(std::promise<R>& p, Fn& fn) { p.set_value(fn()); }
+    template <typename Fn>
+    static void setValue(std::promise<void>& p, Fn& fn) { fn(); p.set_value(); }
+
+    bool popLocal(size_t index, Job& job) {
+        WorkerQueue& q = queues[index];
+        std::lock_guard<std::mutex> lock(q.mtx);
+        if (q.jobs.empty()) return false;
+        job = std::move(q.jobs.back());
+        q.jobs.pop_back();
+        return true;
+    }
+
+    bool steal(size_t victim, Job& job) {
+        WorkerQueue& q = queues[victim];
+        std::unique_lock<std::mutex> lock(q.mtx, std::try_to_lock);   // a busy victim is skipped, not waited on
+        if (!lock.owns_lock() || q.jobs.empty()) return false;
+        job = std::move(q.jobs.front());
+        q.jobs.pop_front();
+        return true;
+    }
+
+    // Own deque first, then every other deque starting at a random victim.
+    bool findJob(size_t self, Job& job) {
+        if (self < queues.size() && popLocal(self, job)) return true;
+        size_t n = queues.size();
+        size_t start = nextRandom() % n;
+        for (size_t i = 0; i < n; ++i) {
+            size_t victim = (start + i) % n;
+            if (victim != self && steal(victim, job)) return true;
+        }
+        return false;
+    }
+
+    bool runPendingJob() {
+        Job job;
+        size_t self = (currentPool == this) ? currentIndex : queues.size();
+        if (!findJob(self, job)) return false;
+        pending.fetch_sub(1, std::memory_order_relaxed);
+        try {
+            job();
+        } catch (const std::exception& e) {
+            failed.fetch_add(1, std::memory_order_relaxed);
+            std::fprintf(stderr, "WorkStealingPool: job threw: %s\n", e.what());
+        } catch (...) {
+            failed.fetch_add(1, std::memory_order_relaxed);
+            std::fprintf(stderr, "WorkStealingPool: job threw an exception\n");
+        }
+        return true;
+    }
+
+    void worker_thread(size_t index) {
+        currentPool = this;
+        currentIndex = index;
+        rngState = 0x9E3779B97F4A7C15ull * (index + 1);
+
+        while (true) {
+            bool ran = false;
+            for (int spin = 0; spin < 64 && !ran; ++spin) {
+                ran = runPendingJob();
+                if (!ran) std::this_thread::yield();
+            }
+            if (ran) continue;
+
+            std::unique_lock<std::mutex> lock(sleepMtx);
+            sleeping.fetch_add(1, std::memory_order_seq_cst);
+            wakeUp.wait(lock, [this] { return stop || pending.load(std::memory_order_seq_cst) > 0; });
+            sleeping.fetch_sub(1, std::memory_order_relaxed);
+            if (stop && pending.load(std::memory_order_relaxed) == 0) return;
+        }
+    }
+
+    static size_t nextRandom() {   // xorshift64, one state per thread
+        uint64_t x = rngState;
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        rngState = x;
+        return (size_t)x;
+    }
+
+    std::vector<WorkerQueue> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> nextQueue{0};   // round-robin target for jobs submitted from outside the pool
+    std::atomic<long> pending{0};       // jobs pushed but not yet taken
+    std::atomic<int> sleeping{0};
+    std::atomic<uint64_t> failed{0};    // see failedJobs()
+    std::mutex sleepMtx;
+    std::condition_variable wakeUp;
+    bool stop = false;
+
+    // Which pool/deque the current thread works for, so nested enqueue() calls stay local.
+    static inline thread_local WorkStealingPool* currentPool = nullptr;
+    static inline thread_local size_t currentIndex = 0;
+    static inline thread_local uint64_t rngState = 0x2545F4914F6CDD1Dull;
+};
+
+#endif // WORK_STEALING_POOL_H
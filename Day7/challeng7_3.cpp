@@ -0,0 +1,121 @@
+
+// Run the Task / PrintTask / ComputeTask classes from Day5/challeng5_2.cpp on a work-stealing thread pool
+// (WorkStealingPool.h) instead of starting a new std::thread for every task.
+
+#include <iostream>
+#include <vector>
+#include <future>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include "WorkStealingPool.h"
+
+using namespace std;
+
+// Base class with pure virtual method (same as Day5/challeng5_2.cpp)
+class Task
+{
+public:
+    virtual void execute() = 0;
+    virtual ~Task() = default;
+};
+
+class PrintTask : public Task
+{
+public:
+    void execute() override
+    {
+        for (int i = 0; i < 10; ++i)
+        {
+            cout << "PrintTask: " + to_string(i) + "\n";   // one string per line so output from workers does not interleave
+        }
+    }
+};
+
+class ComputeTask : public Task
+{
+public:
+    void execute() override
+    {
+        int sum = 0;
+        for (int i = 1; i <= 10; ++i)
+        {
+            sum += i;
+        }
+        result = sum;
+    }
+    int result = 0;
+};
+
+// Instead of runTask() starting a thread, hand the task to the pool and get a future back.
+future<void> runTask(WorkStealingPool &pool, Task *task)
+{
+    return pool.enqueue([task] { task->execute(); });
+}
+
+// Nested spawning: each call splits the range in two, pushes one half as a new job and recurses on the other.
+long long parallelSum(WorkStealingPool &pool, const vector<int> &data, size_t begin, size_t end)
+{
+    if (end - begin <= 4096)
+    {
+        long long sum = 0;
+        for (size_t i = begin; i < end; ++i) sum += data[i];
+        return sum;
+    }
+    size_t mid = begin + (end - begin) / 2;
+    future<long long> left = pool.enqueue([&pool, &data, begin, mid] { return parallelSum(pool, data, begin, mid); });
+    long long right = parallelSum(pool, data, mid, end);
+    return pool.wait(left) + right;   // runs other jobs while waiting instead of blocking the worker
+}
+
+int main()
+{
+    WorkStealingPool pool(4);
+
+    PrintTask printTask;
+    ComputeTask computeTask;
+    future<void> f1 = runTask(pool, &printTask);
+    future<void> f2 = runTask(pool, &computeTask);
+    f1.get();
+    f2.get();
+    cout << "ComputeTask: sum = " << computeTask.result << endl;
+
+    // Arbitrary lambdas with a return value.
+    future<int> answer = pool.enqueue([] { return 6 * 7; });
+    cout << "Lambda returned " << answer.get() << endl;
+
+    // A fire-and-forget job that throws: the worker reports it and keeps running.
+    pool.spawn([] { throw runtime_error("sensor offline"); });
+    while (pool.failedJobs() == 0) this_thread::yield();
+    cout << "Failed spawn() jobs: " << pool.failedJobs() << ", pool still running: "
+         << pool.enqueue([] { return 1; }).get() << endl;
+
+    // Many short tasks: this is where a thread per task (or one shared queue) costs the most.
+    auto start = chrono::steady_clock::now();
+    vector<future<int>> results;
+    results.reserve(100000);
+    for (int i = 0; i < 100000; ++i)
+    {
+        results.push_back(pool.enqueue([i] { return i % 7; }));
+    }
+    long long total = 0;
+    for (auto &r : results) total += r.get();
+    auto ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "100000 short tasks: total = " << total << " in " << ms << " ms" << endl;
+
+    vector<int> data(1 << 22, 1);
+    future<long long> sum = pool.enqueue([&pool, &data] { return parallelSum(pool, data, 0, data.size()); });
+    cout << "Parallel sum = " << sum.get() << endl;
+
+    return 0;
+}
+
+
+/*Why work stealing:
+
+1. Per-worker deques: every worker has its own queue, so there is no single mutex that all workers contend on.
+2. Stealing: a worker whose deque is empty takes the oldest job from the front of a random victim's deque,
+   while the owner keeps taking the newest job from the back. Big, old jobs get stolen; small, new ones stay local.
+3. Job instead of std::function: lambdas up to 64 bytes are stored inside the Job itself, no heap allocation.
+4. Nested jobs: enqueue() from inside a job pushes onto the current worker's deque; pool.wait(future) keeps the
+   worker busy with other jobs while it waits.*/
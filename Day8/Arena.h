@@ -0,0 +1,234 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+// Monotonic arena for short-lived objects (for example the Circle/Rectangle objects of one frame).
+//
+// - Allocation is a pointer bump inside the current block; a new, bigger block is chained on when it runs out.
+// - Nothing is freed individually. reset() runs the pending destructors and rewinds the arena in one go;
+//   if more than one block was used, they are merged into a single block so the next frame fits in one.
+// - Arena derives from std::pmr::memory_resource, so pmr containers can allocate from it:
+//       std::pmr::vector<int> v(&arena);
+// - Arena::create<T>(...) constructs an object whose destructor runs at reset().
+//   Arena::make<T>(...) returns an ArenaPtr<T>, an owning handle that runs the destructor when it goes out of scope
+//   (the memory itself is only reclaimed at reset()). ArenaPtr<Derived> converts to ArenaPtr<Base>.
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+class Arena : public std::pmr::memory_resource {
+public:
+    struct Stats {
+        size_t allocations = 0;      // since the last reset
+        size_t bytesUsed = 0;        // since the last reset, including alignment padding
+        size_t peakBytesUsed = 0;    // highest bytesUsed ever seen
+        size_t blocks = 0;           // blocks currently owned
+        size_t bytesReserved = 0;    // total size of those blocks
+        size_t resets = 0;
+    };
+
+    explicit Arena(size_t initialBlockSize = 64 * 1024) : nextBlockSize(initialBlockSize) {}
+
+    ~Arena() override {
+        runDestructors();
+        freeBlocks();
+    }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+        return do_allocate(bytes, alignment);
+    }
+
+    // Constructs a T in the arena; its destructor runs at reset() (or never, if T is trivially destructible).
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        void* memory = allocate(sizeof(T), alignof(T));
+        T* object = new (memory) T(std::forward<Args>(args)...);
+        if (!std::is_trivially_destructible<T>::value) {
+            void* node = allocate(sizeof(DestructorNode), alignof(DestructorNode));
+            destructors = new (node) DestructorNode{&destroy<T>, object, destructors};
+        }
+        return object;
+    }
+
+    template <typename T> class Ptr;
+
+    // Constructs a T in the arena and hands ownership to the returned handle.
+    template <typename T, typename... Args>
+    Ptr<T> make(Args&&... args) {
+        void* memory = allocate(sizeof(T), alignof(T));
+        T* object = new (memory) T(std::forward<Args>(args)...);
+        return Ptr<T>(object, &destroy<T>, this);
+    }
+
+    // Destroys everything created with create<T>() (newest first) and rewinds the arena.
+    // Every ArenaPtr from this arena must be gone by now.
+    void reset() {
+        runDestructors();
+        assert(liveHandles == 0 && "ArenaPtr outlived Arena::reset()");
+        if (head && head->next) {
+            // Several blocks were needed: replace them with one block big enough for all of them.
+            size_t total = stats.bytesReserved;
+            freeBlocks();
+            addBlock(total);
+        }
+        if (head) {
+            current = head->data();
+            end = reinterpret_cast<char*>(head) + head->size;
+        }
+        stats.allocations = 0;
+        stats.bytesUsed = 0;
+        ++stats.resets;
+    }
+
+    const Stats& statistics() const { return stats; }
+
+private:
+    struct Block {
+        Block* next;
+        size_t size;   // including this header
+        char* data() { return reinterpret_cast<char*>(this) + sizeof(Block); }
+    };
+
+    struct DestructorNode {
+        void (*destroy)(void*);
+        void* object;
+        DestructorNode* next;
+    };
+
+    template <typename T>
+    static void destroy(void* object) { static_cast<T*>(object)->~T(); }
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        char* p = alignUp(current, alignment);
+        if (!current || p + bytes > end) {
+            size_t needed = bytes + alignment + sizeof(Block);
+            while (nextBlockSize < needed) nextBlockSize *= 2;
+            addBlock(nextBlockSize);
+            nextBlockSize *= 2;
+            p = alignUp(current, alignment);
+        }
+        stats.bytesUsed += (p + bytes) - current;
+        if (stats.bytesUsed > stats.peakBytesUsed) stats.peakBytesUsed = stats.bytesUsed;
+        ++stats.allocations;
+        current = p + bytes;
+        return p;
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {}   // monotonic: memory comes back at reset()
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    static char* alignUp(char* p, size_t alignment) {
+        uintptr_t v = reinterpret_cast<uintptr_t>(p);
+        return reinterpret_cast<char*>((v + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    }
+
+    void addBlock(size_t size) {
+        void* memory = std::malloc(size);
+        if (!memory) throw std::bad_alloc();
+        Block* block = new (memory) Block{head, size};
+        head = block;
+        current = block->data();
+        end = reinterpret_cast<char*>(block) + size;
+        ++stats.blocks;
+        stats.bytesReserved += size;
+    }
+
+    void freeBlocks() {
+        while (head) {
+            Block* next = head->next;
+            std::free(head);
+            head = next;
+        }
+        current = end = nullptr;
+        stats.blocks = 0;
+        stats.bytesReserved = 0;
+    }
+
+    void runDestructors() {
+        for (DestructorNode* node = destructors; node; node = node->next) {
+            node->destroy(node->object);
+        }
+        destructors = nullptr;
+    }
+
+    Block* head = nullptr;
+    char* current = nullptr;
+    char* end = nullptr;
+    size_t nextBlockSize;
+    DestructorNode* destructors = nullptr;
+    Stats stats;
+    size_t liveHandles = 0;   // ArenaPtr handles that have not been destroyed yet
+};
+
+// Owning handle for an object living in an Arena. Move-only, like std::unique_ptr, but the memory
+// stays in the arena: the handle only runs the destructor.
+template <typename T>
+class Arena::Ptr {
+public:
+    Ptr() = default;
+    Ptr(Ptr&& other) noexcept { take(other); }
+    template <typename U, typename = typename std::enable_if<std::is_convertible<U*, T*>::value>::type>
+    Ptr(Ptr<U>&& other) noexcept { take(other); }
+
+    Ptr& operator=(Ptr&& other) noexcept {
+        if (this != &other) {
+            release();
+            take(other);
+        }
+        return *this;
+    }
+
+    ~Ptr() { release(); }
+
+    T* get() const { return object; }
+    T* operator->() const { return object; }
+    T& operator*() const { return *object; }
+    explicit operator bool() const { return object != nullptr; }
+
+private:
+    template <typename U> friend class Ptr;
+    friend class Arena;
+
+    Ptr(T* object, void (*destroy)(void*), Arena* arena)
+        : object(object), complete(object), destroy(destroy), arena(arena) {
+        ++arena->liveHandles;
+    }
+
+    template <typename U>
+    void take(Ptr<U>& other) {
+        object = other.object;
+        complete = other.complete;
+        destroy = other.destroy;
+        arena = other.arena;
+        other.object = nullptr;
+        other.complete = nullptr;
+        other.arena = nullptr;
+    }
+
+    void release() {
+        if (object) {
+            destroy(complete);   // destroys the most-derived type, even without a virtual destructor
+            --arena->liveHandles;
+            object = nullptr;
+        }
+    }
+
+    T* object = nullptr;
+    void* complete = nullptr;   // pointer to the most-derived object, for 'destroy'
+    void (*destroy)(void*) = nullptr;
+    Arena* arena = nullptr;
+};
+
+template <typename T>
+using ArenaPtr = Arena::Ptr<T>;
+
+#endif // ARENA_H
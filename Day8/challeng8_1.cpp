@@ -0,0 +1,90 @@
+
+// Allocate the Circle/Rectangle objects of every "frame" from an Arena instead of new/delete,
+// destroy them all at once with reset(), and compare the cost.
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <memory_resource>
+#include "Arena.h"
+#include "../Day4/Shape.h"
+
+using namespace std;
+
+const int kFrames = 200;
+const int kShapesPerFrame = 20000;
+
+double frameWithNewDelete() {
+    double total = 0;
+    vector<Shape*> shapes;
+    shapes.reserve(kShapesPerFrame);
+    for (int f = 0; f < kFrames; ++f) {
+        for (int i = 0; i < kShapesPerFrame; ++i) {
+            if (i % 2 == 0) shapes.push_back(new Circle(1.0 + i % 10));
+            else shapes.push_back(new Rectangle(1.0 + i % 5, 2.0));
+        }
+        for (Shape* s : shapes) total += s->area();
+        for (Shape* s : shapes) delete s;   // one free() per object
+        shapes.clear();
+    }
+    return total;
+}
+
+double frameWithArena(Arena &arena) {
+    double total = 0;
+    for (int f = 0; f < kFrames; ++f) {
+        {
+            // The vector of pointers lives in the arena too (pmr container); it must be gone before reset().
+            pmr::vector<Shape*> shapes(&arena);
+            shapes.reserve(kShapesPerFrame);
+            for (int i = 0; i < kShapesPerFrame; ++i) {
+                if (i % 2 == 0) shapes.push_back(arena.create<Circle>(1.0 + i % 10));
+                else shapes.push_back(arena.create<Rectangle>(1.0 + i % 5, 2.0));
+            }
+            for (Shape* s : shapes) total += s->area();
+        }
+        arena.reset();   // every destructor, then one pointer rewind
+    }
+    return total;
+}
+
+int main() {
+    auto t0 = chrono::steady_clock::now();
+    double heapTotal = frameWithNewDelete();
+    auto t1 = chrono::steady_clock::now();
+
+    Arena arena;
+    double arenaTotal = frameWithArena(arena);
+    auto t2 = chrono::steady_clock::now();
+
+    cout << "new/delete: " << heapTotal << " in " << chrono::duration<double, milli>(t1 - t0).count() << " ms" << endl;
+    cout << "Arena:      " << arenaTotal << " in " << chrono::duration<double, milli>(t2 - t1).count() << " ms" << endl;
+
+    const Arena::Stats &stats = arena.statistics();
+    cout << "Arena stats: peak " << stats.peakBytesUsed << " bytes, " << stats.blocks << " block(s), "
+         << stats.bytesReserved << " bytes reserved, " << stats.resets << " resets" << endl;
+
+    // Owning handles: the destructor runs when the handle goes away; ArenaPtr<Circle> converts to ArenaPtr<Shape>.
+    {
+        vector<ArenaPtr<Shape>> owned;
+        owned.push_back(arena.make<Circle>(2.0));
+        owned.push_back(arena.make<Rectangle>(2.0, 3.0));
+        for (size_t i = 0; i < owned.size(); ++i) {
+            cout << "The area of shape " << i + 1 << " is: " << owned[i]->area() << endl;
+        }
+        cout << arena.statistics().allocations << " allocations since the last reset" << endl;
+    }
+    arena.reset();
+
+    return 0;
+}
+
+
+/*Arena vs new/delete:
+
+1. new: every object is a separate malloc() call with its own bookkeeping; delete is a separate free().
+2. Arena::create: the object is placed right after the previous one in the current block (a pointer bump),
+   so the shapes of one frame are contiguous in memory.
+3. Arena::reset: runs all destructors and rewinds the pointer. The blocks are kept, so the next frame
+   does not call malloc() at all.
+4. std::pmr: Arena is a memory_resource, so pmr::vector / pmr::string can use it directly.*/